@@ -0,0 +1,150 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <dpgo_ros/Command.h>
+#include <dpgo_ros/PGOAgentTransport.h>
+#include <dpgo_ros/Status.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Sequence numbers of the commands received from a single robot. Keeps the highest
+ * received sequence number and a bit mask of the kWindowSize sequence numbers before it,
+ * which are sent back as selective acknowledgements.
+ */
+class CommandSequenceWindow {
+ public:
+  static constexpr uint32_t kWindowSize = 64;
+
+  /**
+   * @brief Record a received sequence number. A new epoch means that the publisher
+   * restarted, and the window starts over.
+   * @param epoch epoch of the publisher
+   * @param seq sequence number (0 for commands without acknowledgement)
+   * @return false if the command is a duplicate, or too old to tell
+   */
+  bool receive(uint32_t epoch, uint32_t seq);
+
+  /**
+   * @brief Check if a received window acknowledges a sequence number
+   * @param highest highest received sequence number
+   * @param mask bit k is set if sequence number highest - 1 - k was received
+   * @param seq
+   * @return
+   */
+  static bool acknowledges(uint32_t highest, uint64_t mask, uint32_t seq);
+
+  uint32_t epoch() const { return mEpoch; }
+  uint32_t highest() const { return mHighest; }
+  uint64_t mask() const { return mMask; }
+
+ private:
+  uint32_t mEpoch = 0;
+  uint32_t mHighest = 0;
+  uint64_t mMask = 0;
+};
+
+/**
+ * @brief Command that was retransmitted, or abandoned because it was not acknowledged in time
+ */
+struct CommandRetransmission {
+  CommandConstPtr msg;
+  // Number of retransmissions so far
+  unsigned num_retransmissions = 0;
+  // Number of robots that have not acknowledged the command
+  size_t num_unacked_robots = 0;
+  // The command reached the maximum number of retransmissions and is no longer sent
+  bool abandoned = false;
+};
+
+/**
+ * @brief Reliable delivery of the commands published by one agent, independent of ROS.
+ * Commands carry the epoch of the agent and a sequence number, and are retransmitted
+ * until every recipient acknowledges them in its status. Commands received from other
+ * agents are acknowledged in the status of this agent. Time is passed in by the caller.
+ */
+class CommandChannel {
+ public:
+  /**
+   * @brief Constructor
+   * @param robot_id ID of this agent
+   * @param num_robots
+   * @param epoch epoch of this agent, which changes when the agent restarts
+   * @param transport used to publish and retransmit commands
+   */
+  CommandChannel(unsigned robot_id, unsigned num_robots, uint32_t epoch, PGOAgentTransport &transport);
+
+  /**
+   * @brief Publish a command that is retransmitted until all recipients acknowledge it
+   * @param msg command, which is assigned the epoch and the next sequence number
+   * @param recipients robots that must acknowledge the command
+   * @param time current time in seconds
+   */
+  void publish(const CommandPtr &msg, const std::vector<unsigned> &recipients, double time);
+
+  /**
+   * @brief Record a command received from another agent (or from this agent)
+   * @param msg
+   * @return false if the command is a duplicate, e.g., a retransmission that was already received
+   */
+  bool receive(const Command &msg);
+
+  /**
+   * @brief Remove a robot from the recipients of the commands acknowledged by its status
+   * @param msg status of the robot
+   */
+  void acknowledge(const Status &msg);
+
+  /**
+   * @brief Fill the acknowledgements of the received commands in a status message of this agent
+   * @param msg
+   */
+  void fillAcknowledgements(Status &msg) const;
+
+  /**
+   * @brief Retransmit the commands that have not been acknowledged within ack_timeout
+   * @param time current time in seconds
+   * @param ack_timeout seconds to wait for acknowledgements before retransmitting
+   * @param max_retransmissions commands are abandoned after this many retransmissions
+   * @param is_active robots that are no longer active are removed from the recipients
+   * @return retransmitted and abandoned commands
+   */
+  std::vector<CommandRetransmission> retransmit(double time, double ack_timeout, unsigned max_retransmissions,
+                                                const std::function<bool(unsigned)> &is_active);
+
+  /**
+   * @brief Number of commands waiting for acknowledgements
+   */
+  size_t numPendingCommands() const { return mPendingCommands.size(); }
+
+ private:
+  struct PendingCommand {
+    CommandPtr msg;
+    // Robots that have not acknowledged the command
+    std::vector<unsigned> unacked_robots;
+    // Time of the latest transmission
+    double last_sent = 0;
+    unsigned num_retransmissions = 0;
+  };
+
+  unsigned mRobotID;
+  uint32_t mEpoch;
+  PGOAgentTransport &mTransport;
+  // Sequence number of the latest published command
+  uint32_t mSequence = 0;
+  std::vector<PendingCommand> mPendingCommands;
+  // Sequence numbers of the commands received from each robot
+  std::vector<CommandSequenceWindow> mReceivedCommands;
+};
+
+}  // namespace dpgo_ros
@@ -0,0 +1,72 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <map>
+#include <optional>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Predict the remaining cost decrease of distributed optimization from the
+ * cost decreases reported at past iterations. The cost is assumed to converge linearly,
+ * with a rate estimated from the total decreases over the last two windows of iterations.
+ */
+class ConvergencePredictor {
+ public:
+  /**
+   * @brief Constructor
+   * @param window number of iterations in each window
+   */
+  explicit ConvergencePredictor(unsigned window = 10);
+
+  /**
+   * @brief Clear all recorded cost decreases
+   */
+  void reset();
+
+  /**
+   * @brief Record the decrease of the global cost at an iteration.
+   * Decreases reported again for the same iteration are ignored.
+   * @param iteration
+   * @param decrease
+   */
+  void addCostDecrease(unsigned iteration, double decrease);
+
+  /**
+   * @brief Total cost decrease of all recorded iterations
+   */
+  double totalDecrease() const { return mTotalDecrease; }
+
+  /**
+   * @brief Estimated convergence rate per iteration, if two full windows have been recorded
+   */
+  std::optional<double> convergenceRate() const;
+
+  /**
+   * @brief Estimated cost decrease of all future iterations (infinity if unknown)
+   */
+  double predictedRemainingDecrease() const;
+
+  /**
+   * @brief Check if the predicted remaining decrease is below the given fraction
+   * of the total decrease so far
+   * @param tolerance
+   */
+  bool converged(double tolerance) const;
+
+ private:
+  // Sum of decreases of iterations in (first, last]
+  double windowDecrease(unsigned first, unsigned last) const;
+
+  unsigned mWindow;
+  std::map<unsigned, double> mDecreases;
+  double mTotalDecrease = 0;
+};
+
+}  // namespace dpgo_ros
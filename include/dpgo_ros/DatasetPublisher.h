@@ -0,0 +1,59 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <pose_graph_tools/PoseGraph.h>
+#include <pose_graph_tools/PoseGraphQuery.h>
+#include <ros/console.h>
+#include <ros/ros.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Serve the local pose graph of each robot from a dataset, in place of
+ * the distributed loop closure front end
+ */
+class DatasetPublisher {
+ public:
+  DatasetPublisher(const ros::NodeHandle &nh_, const ros::NodeHandle &nh_private_);
+
+  ~DatasetPublisher() = default;
+
+ private:
+  ros::NodeHandle nh;
+  ros::NodeHandle nh_private;
+  int num_robots;
+  std::vector<pose_graph_tools::PoseGraph> poseGraphs;
+  std::vector<ros::ServiceServer> poseGraphServers;
+  std::map<unsigned, std::string> robotNames;
+  bool queryPoseGraphCallback(
+      pose_graph_tools::PoseGraphQueryRequest &request,
+      pose_graph_tools::PoseGraphQueryResponse &response);
+
+  /**
+   * @brief Initialize from a single dataset in g2o format
+   * @param filename
+   */
+  void loadFromG2O(const std::string &filename);
+
+  /**
+   * @brief Initialize from a synthetic dataset generated with the parameters under ~synthetic_dataset
+   */
+  void loadFromSynthetic();
+
+  /**
+   * @brief Initialize from the measurements.csv file of each robot
+   */
+  void loadFromMeasurements();
+};
+
+}  // namespace dpgo_ros
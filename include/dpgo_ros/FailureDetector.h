@@ -0,0 +1,75 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Phi accrual failure detector (Hayashibara et al., 2004) for a single peer.
+ * Inter-arrival times of heartbeats are modeled as normally distributed, with the mean
+ * and standard deviation of a sliding window of recent intervals. The suspicion level phi
+ * is -log10 of the probability that the next heartbeat arrives later than the current
+ * time, so phi = 8 corresponds to a false suspicion probability of 1e-8.
+ */
+class PhiAccrualDetector {
+ public:
+  /**
+   * @brief Constructor
+   * @param first_interval expected heartbeat interval before any interval is observed
+   * @param acceptable_pause extra delay tolerated on top of the mean interval
+   * @param min_std_dev lower bound on the standard deviation of intervals
+   * @param window_size number of intervals kept
+   */
+  explicit PhiAccrualDetector(double first_interval = 1.0,
+                              double acceptable_pause = 0,
+                              double min_std_dev = 0.05,
+                              size_t window_size = 100);
+
+  /**
+   * @brief Forget all heartbeats
+   */
+  void reset();
+
+  /**
+   * @brief Record the arrival of a heartbeat. Heartbeats older than the last one are ignored.
+   * @param time arrival time in seconds
+   */
+  void heartbeat(double time);
+
+  /**
+   * @brief Check if a heartbeat has been received
+   */
+  bool hasHeartbeat() const { return mLastHeartbeat.has_value(); }
+
+  /**
+   * @brief Number of recorded intervals
+   */
+  size_t numIntervals() const { return mIntervals.size(); }
+
+  /**
+   * @brief Suspicion level at the given time (0 without heartbeats)
+   * @param time current time in seconds
+   */
+  double phi(double time) const;
+
+ private:
+  double mFirstInterval;
+  double mAcceptablePause;
+  double mMinStdDev;
+  size_t mWindowSize;
+  std::deque<double> mIntervals;
+  double mSum = 0;
+  double mSumSquares = 0;
+  std::optional<double> mLastHeartbeat;
+};
+
+}  // namespace dpgo_ros
@@ -0,0 +1,95 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <dpgo_ros/PGOAgentTransport.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Message bus shared by agents running in the same process without ROS.
+ * Published messages are queued and delivered (by pointer) to subscribers in spinOnce,
+ * mirroring ros::spinOnce.
+ */
+class InMemoryBus {
+ public:
+  /**
+   * @brief Deliver the messages queued before this call
+   * @return number of delivered messages
+   */
+  size_t spinOnce();
+
+  /**
+   * @brief Number of messages waiting to be delivered
+   */
+  size_t numQueuedMessages() const;
+
+ private:
+  friend class InMemoryTransport;
+
+  // Queue delivery of a message published by robot_id to its current subscribers.
+  // With report_arrival, the publishing time is reported as the arrival time.
+  template <typename M>
+  void post(unsigned robot_id,
+            std::function<void(const boost::shared_ptr<M const> &)> PGOAgentMessageHandlers::*handler,
+            const boost::shared_ptr<M const> &msg,
+            bool report_arrival = false) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto it = mSubscribers.find(robot_id);
+    if (it == mSubscribers.end()) return;
+    for (const auto &handlers : it->second) {
+      const auto callback = handlers.*handler;
+      if (!callback) continue;
+      if (report_arrival && handlers.arrival) {
+        const auto arrival = handlers.arrival;
+        const ros::Time time = ros::Time::now();
+        mQueue.emplace_back([callback, arrival, time, msg]() {
+          arrival(time);
+          callback(msg);
+        });
+      } else {
+        mQueue.emplace_back([callback, msg]() { callback(msg); });
+      }
+    }
+  }
+  void subscribe(unsigned robot_id, const PGOAgentMessageHandlers &handlers);
+
+  mutable std::mutex mMutex;
+  std::map<unsigned, std::vector<PGOAgentMessageHandlers>> mSubscribers;
+  std::deque<std::function<void()>> mQueue;
+};
+
+/**
+ * @brief Transport of a single agent on an InMemoryBus
+ */
+class InMemoryTransport : public PGOAgentTransport {
+ public:
+  InMemoryTransport(InMemoryBus &bus, unsigned robot_id);
+
+  void publishCommand(const CommandConstPtr &msg) override;
+  void publishStatus(const StatusConstPtr &msg) override;
+  void publishPublicPoses(const PublicPosesConstPtr &msg) override;
+  void publishAnchor(const PublicPosesConstPtr &msg) override;
+  void publishLiftingMatrix(const MatrixMsgConstPtr &msg) override;
+  void publishPublicMeasurements(const RelativeMeasurementListConstPtr &msg) override;
+  void publishMeasurementWeights(const RelativeMeasurementWeightsConstPtr &msg) override;
+
+  void subscribe(unsigned robot_id, const PGOAgentMessageHandlers &handlers) override;
+
+ private:
+  InMemoryBus &mBus;
+  unsigned mRobotID;
+};
+
+}  // namespace dpgo_ros
@@ -0,0 +1,220 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+/**
+ * @brief Flat store of neighbor poses in the global frame. Poses of each robot are
+ * kept in one contiguous array of d-by-(d+1) matrices (column major), ordered by frame ID.
+ * The total number of poses is bounded, and robots that have not been seen for
+ * a number of rounds can be evicted.
+ */
+class NeighborPoseCache {
+ public:
+  /**
+   * @brief Constructor
+   * @param d dimension of the poses
+   * @param capacity maximum number of stored poses (0 for unbounded)
+   */
+  explicit NeighborPoseCache(unsigned d = 3, size_t capacity = 0);
+
+  /**
+   * @brief Set the dimension of the poses. Clears the cache if the dimension changes.
+   * @param d
+   */
+  void setDimension(unsigned d);
+
+  /**
+   * @brief Set the maximum number of stored poses (0 for unbounded)
+   * @param capacity
+   */
+  void setCapacity(size_t capacity) { mCapacity = capacity; }
+
+  /**
+   * @brief Insert or overwrite a pose, and mark its robot as seen in the given round.
+   * When the cache is full, the least recently seen other robots are evicted first.
+   * @param id
+   * @param T d-by-(d+1) pose
+   * @param round
+   * @return false if the pose cannot be stored within the capacity
+   */
+  bool insert(const PoseID &id, const Matrix &T, unsigned round);
+
+  /**
+   * @brief Look up a pose
+   * @param id
+   * @param T output pose
+   * @return true if the pose is stored
+   */
+  bool find(const PoseID &id, Matrix &T) const;
+
+  /**
+   * @brief Call f(pose_id, pose) for every stored pose, ordered by pose ID
+   */
+  template <typename Func>
+  void forEach(Func f) const {
+    const size_t block_size = mD * (mD + 1);
+    for (const auto &robot : mRobots) {
+      for (size_t i = 0; i < robot.frameIDs.size(); ++i) {
+        f(PoseID(robot.robotID, robot.frameIDs[i]),
+          Eigen::Map<const Matrix>(robot.poses.data() + i * block_size, mD, mD + 1));
+      }
+    }
+  }
+
+  /**
+   * @brief Remove the poses of robots that have not been seen since round - max_idle_rounds
+   * @param round current round
+   * @param max_idle_rounds
+   * @return number of evicted robots
+   */
+  size_t evictIdleRobots(unsigned round, unsigned max_idle_rounds);
+
+  /**
+   * @brief Remove all poses
+   */
+  void clear() { mRobots.clear(); mSize = 0; }
+
+  /**
+   * @brief Number of stored poses
+   */
+  size_t size() const { return mSize; }
+
+  /**
+   * @brief Number of robots with stored poses
+   */
+  size_t numRobots() const { return mRobots.size(); }
+
+  /**
+   * @brief Number of bytes allocated by the cache
+   */
+  size_t memoryUsage() const;
+
+ private:
+  struct RobotPoses {
+    unsigned robotID;
+    unsigned lastSeenRound;
+    std::vector<unsigned> frameIDs;
+    std::vector<double> poses;
+  };
+
+  // Remove the least recently seen robot other than robot_id
+  bool evictLeastRecentRobot(unsigned robot_id);
+
+  unsigned mD;
+  size_t mCapacity;
+  size_t mSize;
+  // Ordered by robot ID
+  std::vector<RobotPoses> mRobots;
+};
+
+/**
+ * @brief Open addressing (linear probing) hash table from shared loop closures to
+ * their weights. All entries live in a single array. The number of entries is bounded,
+ * and edges with robots that have not been seen for a number of rounds can be evicted.
+ */
+class EdgeWeightCache {
+ public:
+  /**
+   * @brief Constructor
+   * @param capacity maximum number of stored weights (0 for unbounded)
+   */
+  explicit EdgeWeightCache(size_t capacity = 0);
+
+  /**
+   * @brief Set the maximum number of stored weights (0 for unbounded)
+   * @param capacity
+   */
+  void setCapacity(size_t capacity) { mCapacity = capacity; }
+
+  /**
+   * @brief Insert or overwrite the weight of an edge, and mark both robots as seen
+   * in the given round. When the cache is full, edges of the least recently seen robots
+   * are evicted first.
+   * @param edge_id
+   * @param weight
+   * @param round
+   * @return false if the weight cannot be stored within the capacity
+   */
+  bool insert(const EdgeID &edge_id, double weight, unsigned round);
+
+  /**
+   * @brief Look up the weight of an edge
+   * @param edge_id
+   * @param weight output weight
+   * @return true if the weight is stored
+   */
+  bool find(const EdgeID &edge_id, double &weight) const;
+
+  /**
+   * @brief Call f(edge_id, weight) for every stored weight (in no particular order)
+   */
+  template <typename Func>
+  void forEach(Func f) const {
+    for (const auto &slot : mSlots) {
+      if (!slot.occupied) continue;
+      f(EdgeID(PoseID(slot.r1, slot.p1), PoseID(slot.r2, slot.p2)), slot.weight);
+    }
+  }
+
+  /**
+   * @brief Remove the weights of edges with a robot that has not been seen since
+   * round - max_idle_rounds
+   * @param round current round
+   * @param max_idle_rounds
+   * @return number of evicted robots
+   */
+  size_t evictIdleRobots(unsigned round, unsigned max_idle_rounds);
+
+  /**
+   * @brief Remove all weights
+   */
+  void clear();
+
+  /**
+   * @brief Number of stored weights
+   */
+  size_t size() const { return mSize; }
+
+  /**
+   * @brief Number of bytes allocated by the cache
+   */
+  size_t memoryUsage() const;
+
+ private:
+  struct Slot {
+    uint32_t r1, p1, r2, p2;
+    double weight;
+    bool occupied;
+  };
+  static constexpr unsigned kNeverSeen = std::numeric_limits<unsigned>::max();
+
+  size_t findSlot(const EdgeID &edge_id) const;
+  void rehash(size_t num_slots);
+  // Remove all edges with one of the given robots
+  void removeRobots(const std::vector<bool> &removed);
+  void markSeen(unsigned robot_id, unsigned round);
+
+  size_t mCapacity;
+  size_t mSize;
+  // Number of slots is zero or a power of two, and at most half of the slots are occupied
+  std::vector<Slot> mSlots;
+  // Last round in which each robot was seen (indexed by robot ID)
+  std::vector<unsigned> mLastSeenRound;
+};
+
+}  // namespace dpgo_ros
@@ -10,22 +10,120 @@
 
 #include <DPGO/PGOAgent.h>
 #include <dpgo_ros/Command.h>
+#include <dpgo_ros/CommandChannel.h>
+#include <dpgo_ros/ConvergencePredictor.h>
+#include <dpgo_ros/FailureDetector.h>
+#include <dpgo_ros/NeighborCache.h>
+#include <dpgo_ros/PGOAgentTransport.h>
 #include <dpgo_ros/PublicPoses.h>
 #include <dpgo_ros/RelativeMeasurementList.h>
 #include <dpgo_ros/RelativeMeasurementWeights.h>
 #include <dpgo_ros/QueryLiftingMatrix.h>
 #include <dpgo_ros/Status.h>
+#include <dpgo_ros/chain_reduction.h>
+#include <dpgo_ros/checkpoint.h>
+#include <dpgo_ros/utils.h>
 #include <pose_graph_tools/PoseGraph.h>
 #include <visualization_msgs/Marker.h>
 #include <std_msgs/UInt16MultiArray.h>
+#include <ros/callback_queue.h>
 #include <ros/console.h>
 #include <ros/ros.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <list>
+#include <optional>
 
 using namespace DPGO;
 
 namespace dpgo_ros {
 
-typedef std::vector<ros::Subscriber> SubscriberVector;
+/**
+ * @brief Precomputed plan to send public poses to a single neighbor.
+ * The messages are allocated once per round and refilled in place at every publish.
+ */
+struct PublicPosesSendPlan {
+  // ID of the receiving neighbor
+  unsigned neighbor_id;
+  // Local indices of the poses shared with this neighbor
+  std::vector<unsigned> pose_indices;
+  // Reusable messages for public poses and auxiliary public poses. Subscribers may still
+  // hold the last published message, so publishing alternates between two messages.
+  std::array<PublicPosesPtr, 2> msgs;
+  std::array<PublicPosesPtr, 2> aux_msgs;
+  // Index of the message to publish next
+  unsigned next_msg = 0;
+  unsigned next_aux_msg = 0;
+};
+
+/**
+ * @brief Weights of the shared loop closures exchanged with a single neighbor.
+ * After a full table is sent, edges are referenced by their index in this table
+ * and only weights that changed are transmitted.
+ */
+struct SharedEdgeWeightTable {
+  // Shared loop closures in the order agreed by the last full table
+  std::vector<EdgeID> edges;
+  // Index of each edge in PoseGraph::sharedLoopClosures() (only used by the sender)
+  std::vector<size_t> measurement_indices;
+  // Weights last sent (sender) or applied (receiver)
+  std::vector<float> weights;
+  std::vector<bool> fixed_weights;
+  // Version last sent (sender) or applied (receiver)
+  unsigned version = 0;
+  // The receiver missed an update and waits for the full table
+  bool full_table_requested = false;
+};
+
+/**
+ * @brief Mailbox slot that keeps only the newest public poses received from a neighbor.
+ * Messages are deserialized only when the neighbor poses are needed.
+ */
+struct PublicPosesMailboxSlot {
+  // Newest message received, ordered by (instance_number, iteration_number)
+  PublicPosesConstPtr msg;
+  // True if msg has not been applied to the neighbor poses yet
+  bool pending = false;
+};
+
+/**
+ * @brief Pose graph query running on a separate thread, so that waiting for the front end
+ * does not block the callback queue. The result is empty if the query failed.
+ */
+struct PoseGraphQuery {
+  enum class Purpose {
+    Round,         // Pose graph of a new round of distributed optimization
+    OnlineUpdate,  // New measurements during optimization
+    Summary        // Summary of the front end pose graph for change-triggered rounds
+  };
+  Purpose purpose;
+  ros::Time start_time;
+  // The result is no longer needed, e.g., after a timeout or a reset
+  bool abandoned = false;
+  std::future<std::optional<pose_graph_tools::PoseGraph>> result;
+};
+
+/**
+ * @brief Statistics collected while evaluating loop closure weights
+ */
+struct LoopClosureWeightStatistics {
+  // Number of loop closures whose residual was evaluated
+  size_t num_evaluated = 0;
+  // Number of loop closures rejected (weight fixed at zero)
+  size_t num_rejected = 0;
+  // Largest evaluated residual
+  double max_residual = 0;
+
+  LoopClosureWeightStatistics &operator+=(const LoopClosureWeightStatistics &other) {
+    num_evaluated += other.num_evaluated;
+    num_rejected += other.num_rejected;
+    max_residual = std::max(max_residual, other.max_residual);
+    return *this;
+  }
+};
 
 /**
  * @brief This class extends PGOAgentParameters with several ROS related settings
@@ -34,7 +132,8 @@ class PGOAgentROSParameters : public PGOAgentParameters {
  public:
   enum class UpdateRule {
     Uniform, // Uniform sampling 
-    RoundRobin  // Round robin
+    RoundRobin,  // Round robin
+    LoadBalanced  // Sampling by expected cost decrease per second of local optimization
   };
 
   // Rule to select the next robot for update
@@ -70,6 +169,117 @@ class PGOAgentROSParameters : public PGOAgentParameters {
   // Maximum time in seconds before considering a robot disconnected
   double timeoutThreshold;
 
+  // Maximum time in seconds to wait for the pose graph from the front-end (0 to wait indefinitely)
+  double poseGraphQueryTimeout;
+
+  // UPDATE, UPDATE_WEIGHT, TERMINATE and INITIALIZE commands are retransmitted up to this many
+  // times until all active robots acknowledge them (0 to disable acknowledgements)
+  int maxCommandRetransmissions;
+
+  // Time in seconds to wait for acknowledgements before retransmitting a command
+  double commandAckTimeout;
+
+  // Detect failed robots from the arrival times of their status and command messages
+  // (phi accrual failure detector), instead of waiting for the command channel timeout
+  bool adaptiveFailureDetection;
+
+  // Period in seconds of the NOOP heartbeats published with adaptive failure detection
+  double heartbeatPeriod;
+
+  // Suspicion level above which a robot is considered disconnected
+  double phiThreshold;
+
+  // When the leader fails during optimization, let a designated successor take over
+  // and resume the current round, instead of resetting all robots
+  bool leaderFailover;
+
+  // Under GNC, reject converged outliers after every weight update instead of only at termination
+  bool rejectOutliersAtWeightUpdate;
+
+  // Under GNC, permanently fix a loop closure weight that stayed within weightConvergenceThreshold
+  // of 0 or 1 for this many consecutive weight updates (0 to disable)
+  int weightFixingPatience;
+
+  // File used to checkpoint the agent state after each optimization round (empty to disable)
+  std::string checkpointPath;
+
+  // Prefix prepended to the topics of other agents, e.g., to receive them through a network emulator
+  std::string incomingTopicPrefix;
+
+  // Poll the front end for new measurements during optimization and add them
+  // to the pose graph without restarting the round (synchronous mode only)
+  bool onlinePoseGraphUpdate;
+
+  // Period in seconds for polling new measurements during optimization
+  double onlineUpdatePeriod;
+
+  // Start a new round only when the team pose graph has changed enough, instead of
+  // periodically (the leader still waits for minRoundInterval after the last round)
+  bool changeTriggeredRounds;
+
+  // Period in seconds for summarizing the front end pose graph while idle
+  double poseGraphSummaryPeriod;
+
+  // Number of new loop closures across the team that triggers a new round
+  int roundTriggerLoopClosures;
+
+  // Minimum and maximum time in seconds between the end of a round and the next round
+  double minRoundInterval;
+  double maxRoundInterval;
+
+  // Let the leader terminate optimization (or end a robust optimization inner loop early)
+  // when the predicted remaining decrease of the global cost is small
+  bool predictiveTermination;
+
+  // Number of iterations in each window used to estimate the convergence rate
+  int predictionWindow;
+
+  // Terminate when the predicted remaining cost decrease falls below this fraction
+  // of the decrease achieved so far
+  double predictedDecreaseTolerance;
+
+  // Also terminate when the aggregated Riemannian gradient norm falls below this value (0 to disable)
+  double globalGradNormTolerance;
+
+  // Optimize a reduced pose graph in which chains of odometry between loop closure
+  // endpoints and keyframes are collapsed into single measurements
+  bool reduceOdometryChains;
+
+  // Keep every keyframeInterval-th pose in the reduced pose graph (0 to only keep required poses)
+  int keyframeInterval;
+
+  // Maximum number of neighbor poses, and of shared loop closure weights, kept between rounds
+  // (0 for unbounded)
+  int neighborCacheCapacity;
+
+  // Evict cached poses and weights of robots not seen for this many rounds (0 to never evict)
+  int neighborCacheEvictionRounds;
+
+  // Start at relaxation rank d+1 and increase the rank by one (up to the relaxation rank r)
+  // after each round that converges to a solution of full rank
+  bool adaptiveRelaxationRank;
+
+  // The lifted solution is considered rank deficient if the ratio between the (d+1)-th largest
+  // and the largest eigenvalue of the Gram matrix of the lifted rotations is below this value
+  double rankDeficiencyTolerance;
+
+  // Maximum wall time (sec) of a local solve in synchronous mode (0 for unlimited). When a
+  // local solve exceeds its time budget, the robot passes the turn with its previous iterate,
+  // and its new iterate is published once the solve finishes.
+  double localSolveTimeBudget;
+
+  // The time budget is this factor times the median local solve time of the team
+  // (capped at localSolveTimeBudget)
+  double timeBudgetMedianFactor;
+
+  // With the LoadBalanced update rule, each robot is selected with probability at least
+  // this fraction of that of the robot with the highest expected cost decrease per second
+  double loadBalanceMinWeight;
+
+  // Keep the data matrices of the pose graph across rounds when its measurements and
+  // weights are unchanged (L2 cost only, and not with complete reset or chain reduction)
+  bool reuseDataMatrices;
+
   // Default constructor
   PGOAgentROSParameters(unsigned dIn, unsigned rIn, unsigned numRobotsIn)
       : PGOAgentParameters(dIn, rIn, numRobotsIn),
@@ -83,7 +293,39 @@ class PGOAgentROSParameters : public PGOAgentParameters {
         maxDelayedIterations(3),
         weightConvergenceThreshold(1e-6),
         interUpdateSleepTime(0),
-        timeoutThreshold(15) {}
+        timeoutThreshold(15),
+        poseGraphQueryTimeout(0),
+        maxCommandRetransmissions(5),
+        commandAckTimeout(0.2),
+        adaptiveFailureDetection(false),
+        heartbeatPeriod(0.2),
+        phiThreshold(8.0),
+        leaderFailover(false),
+        rejectOutliersAtWeightUpdate(false),
+        weightFixingPatience(0),
+        checkpointPath(""),
+        incomingTopicPrefix(""),
+        onlinePoseGraphUpdate(false),
+        onlineUpdatePeriod(5.0),
+        changeTriggeredRounds(false),
+        poseGraphSummaryPeriod(5.0),
+        roundTriggerLoopClosures(5),
+        minRoundInterval(10.0),
+        maxRoundInterval(120.0),
+        predictiveTermination(false),
+        predictionWindow(10),
+        predictedDecreaseTolerance(1e-3),
+        globalGradNormTolerance(0),
+        reduceOdometryChains(false),
+        keyframeInterval(10),
+        neighborCacheCapacity(100000),
+        neighborCacheEvictionRounds(20),
+        adaptiveRelaxationRank(false),
+        rankDeficiencyTolerance(1e-4),
+        localSolveTimeBudget(0),
+        timeBudgetMedianFactor(3.0),
+        loadBalanceMinWeight(0.05),
+        reuseDataMatrices(false) {}
 
   inline friend std::ostream &operator<<(
       std::ostream &os, const PGOAgentROSParameters &params) {
@@ -102,6 +344,38 @@ class PGOAgentROSParameters : public PGOAgentParameters {
     os << "Measurement weight convergence threshold: " << params.weightConvergenceThreshold << std::endl;
     os << "Inter update sleep time: " << params.interUpdateSleepTime << std::endl;
     os << "Timeout threshold: " << params.timeoutThreshold << std::endl;
+    os << "Pose graph query timeout: " << params.poseGraphQueryTimeout << std::endl;
+    os << "Max command retransmissions: " << params.maxCommandRetransmissions << std::endl;
+    os << "Command acknowledgement timeout: " << params.commandAckTimeout << std::endl;
+    os << "Adaptive failure detection: " << params.adaptiveFailureDetection << std::endl;
+    os << "Heartbeat period: " << params.heartbeatPeriod << std::endl;
+    os << "Phi threshold: " << params.phiThreshold << std::endl;
+    os << "Leader failover: " << params.leaderFailover << std::endl;
+    os << "Reject outliers at weight update: " << params.rejectOutliersAtWeightUpdate << std::endl;
+    os << "Weight fixing patience: " << params.weightFixingPatience << std::endl;
+    os << "Checkpoint path: " << params.checkpointPath << std::endl;
+    os << "Incoming topic prefix: " << params.incomingTopicPrefix << std::endl;
+    os << "Online pose graph update: " << params.onlinePoseGraphUpdate << std::endl;
+    os << "Online update period: " << params.onlineUpdatePeriod << std::endl;
+    os << "Change triggered rounds: " << params.changeTriggeredRounds << std::endl;
+    os << "Pose graph summary period: " << params.poseGraphSummaryPeriod << std::endl;
+    os << "Round trigger loop closures: " << params.roundTriggerLoopClosures << std::endl;
+    os << "Minimum round interval: " << params.minRoundInterval << std::endl;
+    os << "Maximum round interval: " << params.maxRoundInterval << std::endl;
+    os << "Predictive termination: " << params.predictiveTermination << std::endl;
+    os << "Prediction window: " << params.predictionWindow << std::endl;
+    os << "Predicted decrease tolerance: " << params.predictedDecreaseTolerance << std::endl;
+    os << "Global gradnorm tolerance: " << params.globalGradNormTolerance << std::endl;
+    os << "Reduce odometry chains: " << params.reduceOdometryChains << std::endl;
+    os << "Keyframe interval: " << params.keyframeInterval << std::endl;
+    os << "Neighbor cache capacity: " << params.neighborCacheCapacity << std::endl;
+    os << "Neighbor cache eviction rounds: " << params.neighborCacheEvictionRounds << std::endl;
+    os << "Adaptive relaxation rank: " << params.adaptiveRelaxationRank << std::endl;
+    os << "Rank deficiency tolerance: " << params.rankDeficiencyTolerance << std::endl;
+    os << "Local solve time budget: " << params.localSolveTimeBudget << std::endl;
+    os << "Time budget median factor: " << params.timeBudgetMedianFactor << std::endl;
+    os << "Load balance minimum weight: " << params.loadBalanceMinWeight << std::endl;
+    os << "Reuse data matrices: " << params.reuseDataMatrices << std::endl;
     return os;
   }
 
@@ -113,17 +387,38 @@ class PGOAgentROSParameters : public PGOAgentParameters {
       case UpdateRule::RoundRobin: {
         return "RoundRobin";
       }
+      case UpdateRule::LoadBalanced: {
+        return "LoadBalanced";
+      }
     }
     return "";
   }
 };
 
+/**
+ * @brief Load agent ID and parameters from the private namespace of a node or nodelet
+ * @param nh_private private node handle
+ * @param agent_id output ID of the agent
+ * @return parameters, or std::nullopt if a required parameter is missing or invalid
+ */
+std::optional<PGOAgentROSParameters> loadPGOAgentROSParameters(const ros::NodeHandle &nh_private,
+                                                               unsigned &agent_id);
+
 class PGOAgentROS : public PGOAgent {
  public:
-  PGOAgentROS(const ros::NodeHandle &nh_, unsigned ID,
-              const PGOAgentROSParameters &params);
+  /**
+   * @brief Constructor
+   * @param nh_ node handle
+   * @param nh_private_ private node handle
+   * @param ID robot ID
+   * @param params parameters
+   * @param transport transport for inter-agent messages (if null, ROS topics are used)
+   */
+  PGOAgentROS(const ros::NodeHandle &nh_, const ros::NodeHandle &nh_private_,
+              unsigned ID, const PGOAgentROSParameters &params,
+              std::unique_ptr<PGOAgentTransport> transport = nullptr);
 
-  ~PGOAgentROS() = default;
+  ~PGOAgentROS();
 
   /**
    * @brief Function to be called at every ROS spin.
@@ -131,14 +426,21 @@ class PGOAgentROS : public PGOAgent {
   void runOnce();
 
  private:
-  // ROS node handle
+  // Subscribe to other agents and start the timers, after announcing this robot at startup
+  void start();
+
+  // ROS node handles
   ros::NodeHandle nh;
+  ros::NodeHandle nh_private;
 
   // A copy of the parameter struct
   const PGOAgentROSParameters mParamsROS;
 
   // ID of the cluster that this robot belongs to
-  unsigned mClusterID;
+  std::atomic<unsigned> mClusterID;
+
+  // Leader that failed during the current round and was replaced by its successor
+  std::optional<unsigned> mFailedLeaderID;
 
   // Received request to iterate with optimization in synchronous mode
   bool mSynchronousOptimizationRequested = false;
@@ -158,12 +460,52 @@ class PGOAgentROS : public PGOAgent {
   // Total bytes of public poses received
   size_t mTotalBytesReceived;
 
+  // Latest public poses received from each robot (indexed by robot ID)
+  std::vector<PublicPosesMailboxSlot> mPublicPosesMailbox;
+  std::vector<PublicPosesMailboxSlot> mAuxPublicPosesMailbox;
+
+  // Number of public poses messages dropped because a newer message was received
+  size_t mNumStalePublicPoses = 0;
+
   // Elapsed time for the latest update
   double mIterationElapsedMs;
 
+  // Local solve running on a worker thread (only when a time budget is set)
+  std::future<bool> mLocalSolve;
+  std::chrono::high_resolution_clock::time_point mLocalSolveStartTime;
+  ros::Time mLocalSolveDeadline;
+  unsigned mLocalSolveIteration = 0;
+  // Time budget of the next local solve received with the UPDATE command (0 for unlimited)
+  double mLocalSolveTimeBudgetMs = 0;
+  // Set if the turn was passed to the next robot because the local solve exceeded its budget
+  bool mLocalSolveTurnPassed = false;
+  // Number of UPDATE commands for other robots received during the local solve
+  unsigned mDeferredPassiveIterations = 0;
+  // Number of local solves that exceeded their time budget in this round
+  size_t mNumLocalSolveOverruns = 0;
+
+  // Iteration of the latest local optimization of this robot (0 if none in this round)
+  unsigned mLastOptimizedIteration = 0;
+
+  // Maximum change of loop closure weights at the latest weight update
+  double mLastWeightChange = 1;
+
+  // Predictor of the remaining cost decrease since the latest weight update (leader and its successor)
+  ConvergencePredictor mConvergencePredictor;
+  unsigned mPredictorStartIteration = 0;
+
+  // Set by the leader when the last round converged to a full rank solution,
+  // so that the next round starts immediately at a higher relaxation rank
+  bool mRankIncreasePending = false;
+  // Set by the leader when it terminates while its local solve is still running
+  bool mRankIncreaseCheckPending = false;
+
   // Global optimization start time
   ros::Time mGlobalStartTime, mLastCommandTime;
 
+  // Time of the last check for timeouts and suspected robots
+  ros::Time mLastTimeoutCheckTime;
+
   // Map from robot ID to name
   std::map<unsigned, std::string> mRobotNames;
 
@@ -178,18 +520,81 @@ class PGOAgentROS : public PGOAgent {
   // Store if other robots are currently connected 
   std::vector<bool> mTeamConnected;  
 
+  // Failure detectors fed by the messages received from each robot
+  std::vector<PhiAccrualDetector> mFailureDetectors;
+
   // Store the current cluster each robot belongs to
   std::vector<unsigned> mTeamClusterID;
 
+  // A received command has not been acknowledged in a status message yet
+  bool mCommandAckRequested = false;
+
   // Store the latest optimized trajectory and loop closures for visualization
   std::optional<PoseArray> mCachedPoses;
   std::optional<visualization_msgs::Marker> mCachedLoopClosureMarkers;
 
   // Store the latest SE(d) poses from neighbors in the global frame 
-  std::map<PoseID, Pose, ComparePoseID> mCachedNeighborPoses; 
+  NeighborPoseCache mCachedNeighborPoses;
 
-  // Store the latest measurement weights with neighbors
-  std::unordered_map<EdgeID, double, HashEdgeID> mCachedEdgeWeights;
+  // Store the latest measurement weights with neighbors (indexed by full pose indices)
+  EdgeWeightCache mCachedEdgeWeights;
+
+  // Measurements restored from the checkpoint (indexed by full pose indices), whose
+  // weights are applied to the next pose graph received from the front end
+  std::vector<RelativeSEMeasurement> mCheckpointMeasurements;
+
+  // Per-neighbor plans for publishing public poses (rebuilt once per round)
+  std::vector<PublicPosesSendPlan> mPublicPosesSendPlans;
+  bool mPublicPosesSendPlansValid = false;
+
+  // Buffer used to read shared poses without reallocation
+  Matrix mSharedPoseBuffer;
+
+  // Weight tables for shared loop closures this robot is responsible for (indexed by neighbor)
+  std::map<unsigned, SharedEdgeWeightTable> mSentEdgeWeightTables;
+  bool mSentEdgeWeightTablesValid = false;
+
+  // Weight tables received from neighbors responsible for the shared loop closures
+  std::map<unsigned, SharedEdgeWeightTable> mReceivedEdgeWeightTables;
+
+  // Number of timer ticks since the last full weight tables were sent
+  unsigned mWeightTablePublishCount = 0;
+
+  // Data matrices need to be recomputed due to received weight changes
+  bool mDataMatricesStale = false;
+
+  // Measurements received from the front end at the start of the previous round (with reuseDataMatrices)
+  std::vector<RelativeSEMeasurement> mRoundMeasurements;
+
+  // Number of consecutive weight updates that each loop closure weight stayed converged
+  // (positive if converged to one, negative if converged to zero)
+  std::unordered_map<EdgeID, int, HashEdgeID> mWeightConvergenceCounts;
+
+  // Asynchronous writer of the latest checkpoint
+  std::future<void> mCheckpointWriter;
+
+  // The next round is initialized from a loaded checkpoint
+  bool mWarmStartPending = false;
+
+  // Shared loop closures received during optimization that involve local poses
+  // not yet added to the pose graph
+  std::vector<RelativeSEMeasurement> mPendingSharedLoopClosures;
+
+  // Message callbacks received during the local solve or the pose graph query of a new round
+  std::vector<std::function<void()>> mDeferredCallbacks;
+
+  // Pose graph queries still running, including abandoned ones
+  std::list<PoseGraphQuery> mPoseGraphQueries;
+
+  // Latest status published while no local solve was running
+  StatusPtr mStatusSnapshot;
+
+  // Correspondence between the front end pose graph and the reduced pose graph being optimized
+  std::optional<ChainReduction> mChainReduction;
+
+  // Summary of the pose graph used in the last round and of the latest front end pose graph
+  PoseGraphSummary mRoundPoseGraphSummary;
+  PoseGraphSummary mLatestPoseGraphSummary;
 
   // Last time reset is called
   ros::Time mLastResetTime;
@@ -197,6 +602,10 @@ class PGOAgentROS : public PGOAgent {
   // Time this node is launched
   ros::Time mLaunchTime;
 
+  // Number of NOOP commands published at startup, and whether startup is complete
+  unsigned mNumStartupNoops = 0;
+  bool mStarted = false;
+
   // Time this node last performed an iteration
   std::optional<ros::Time> mLastUpdateTime;
 
@@ -209,12 +618,53 @@ class PGOAgentROS : public PGOAgent {
   // Tasks to run in asynchronous mode at every ROS spin
   void runOnceAsynchronous();
 
-  // Request latest local pose graph
-  bool requestPoseGraph();
+  // Request latest local pose graph. The round continues in finishRequestPoseGraph.
+  void requestPoseGraph();
+
+  // Add the pose graph of a new round, return false if it is empty
+  bool processPoseGraph(const pose_graph_tools::PoseGraph &pose_graph);
+
+  // Report the pose graph of a new round to the team, and start initialization (leader only)
+  void finishRequestPoseGraph(bool received_pose_graph);
+
+  // Start querying the local pose graph from the front end. Return false if a query
+  // with the same purpose is still running.
+  bool startPoseGraphQuery(PoseGraphQuery::Purpose purpose);
+
+  // Handle the pose graph queries that completed or timed out
+  void pollPoseGraphQueries();
+
+  // True while waiting for the pose graph of a new round
+  bool roundPoseGraphQueryPending() const;
+
+  // Add the measurements of a pose graph queried during optimization
+  void updatePoseGraphOnline(const pose_graph_tools::PoseGraph &pose_graph);
+
+  // Resume (or terminate) optimization after a command timeout (leader only)
+  void resumeAfterTimeout();
+
+  // Publish the optimized trajectory and loop closures after a random delay,
+  // so that the robots do not publish at the same time
+  void schedulePublishResults();
+
+  // Pose indices exchanged with other robots refer to the front end pose graph,
+  // which differs from the optimized pose graph when odometry chains are reduced
+  unsigned externalPoseIndex(unsigned index) const;
+  // Return false if the pose is not in the optimized pose graph
+  bool internalPoseIndex(unsigned external_index, unsigned &index) const;
+  RelativeSEMeasurement externalMeasurement(const RelativeSEMeasurement &m) const;
+  bool internalMeasurement(RelativeSEMeasurement &m) const;
+
+  // Add new measurements to the pose graph during optimization. New poses are
+  // initialized by odometry from the current iterate. Return the added shared loop closures.
+  std::vector<RelativeSEMeasurement> growPoseGraph(const std::vector<RelativeSEMeasurement> &measurements);
 
   // Attempt to initialize optimization
   bool tryInitialize();
 
+  // Check if the team pose graph has changed enough to start a new round (leader only)
+  bool roundTriggered(double elapsed_sec);
+
   // Get the ID of the current cluster
   unsigned getClusterID() const;
 
@@ -224,6 +674,28 @@ class PGOAgentROS : public PGOAgent {
   // Update cluster for this robot
   void updateCluster();
 
+  // Robot designated to take over if the leader fails (numRobots if none), i.e.,
+  // the lowest ID active robot other than the leader
+  unsigned leaderSuccessor() const;
+
+  // Active state of every robot, indexed by robot ID
+  std::vector<bool> activeRobotFlags() const;
+
+  // Return true if this robot keeps the leader-only state, i.e., it is the leader or its successor
+  bool tracksLeaderState() const;
+
+  // React to a failed leader: take over, wait for the successor, or reset
+  void handleLeaderFailure();
+
+  // Take over as leader and resume the current round
+  void takeOverLeadership();
+
+  // Follow the successor that takes over from a failed leader. Return false if the command is rejected.
+  bool acceptLeaderTakeover(const CommandConstPtr &msg);
+
+  // Resume synchronous optimization at the given iteration (after RECOVER or TAKEOVER)
+  void resumeOptimization(unsigned iteration);
+
   // Get the cluster a robot belongs to
   unsigned getRobotClusterID(unsigned robot_id) const;
 
@@ -234,6 +706,12 @@ class PGOAgentROS : public PGOAgent {
   // Return true if the robot is connected
   bool isRobotConnected(unsigned robot_id) const;
 
+  // Record the arrival of a message from a robot in its failure detector
+  void receivedHeartbeat(unsigned robot_id, const ros::Time &arrival);
+
+  // Return true if the failure detector suspects that the robot has failed
+  bool isRobotSuspected(unsigned robot_id) const;
+
   // Update the set of active robots based on connectivity
   void setActiveRobots();
 
@@ -243,13 +721,17 @@ class PGOAgentROS : public PGOAgent {
   // Publish status
   void publishStatus();
 
+  // Set the cluster, stamp, command acknowledgements and weight table requests of a status
+  void fillStatusAcknowledgements(Status &msg);
+
   // Publish command to request pose graph
   void publishRequestPoseGraphCommand();
 
   // Publish initialize command
   void publishInitializeCommand();
 
-  // Publish update command
+  // Publish update command to the robot selected by the update rule,
+  // or RECOVER if no robot other than this one (still solving) is eligible
   void publishUpdateCommand();
   // Publish update command and specify next robot to update
   void publishUpdateCommand(unsigned robot_id);
@@ -272,6 +754,12 @@ class PGOAgentROS : public PGOAgent {
   // Publish No op command (for debugging)
   void publishNoopCommand();
 
+  // Publish a command that is retransmitted until all active robots acknowledge it
+  void publishAcknowledgedCommand(const CommandPtr &msg);
+
+  // Retransmit commands that have not been acknowledged in time
+  void retransmitCommands();
+
   // Publish lifting matrix
   void publishLiftingMatrix();
 
@@ -296,11 +784,29 @@ class PGOAgentROS : public PGOAgent {
   // Publish latest public poses
   void publishPublicPoses(bool aux = false);
 
+  // Compute the per-neighbor plans used by publishPublicPoses
+  void buildPublicPosesSendPlans();
+  void invalidatePublicPosesSendPlans();
+
   // Publish shared loop closures between this robot and others
   void publishPublicMeasurements();
+  void publishPublicMeasurements(const std::vector<RelativeSEMeasurement> &shared_loop_closures);
+
+  // Publish weights for the responsible inter-robot loop closures.
+  // Unless full_table is true, only weights changed since the last message are sent.
+  void publishMeasurementWeights(bool full_table = false);
+
+  // Compute the weight tables used by publishMeasurementWeights
+  void buildSentEdgeWeightTables();
+
+  // Recompute data matrices if received weights changed since the last call
+  void refreshDataMatrices();
 
-  // Publish weights for the responsible inter-robot loop closures
-  void publishMeasurementWeights();
+  // Check if the pose graph and its data matrices are kept across rounds
+  bool reuseDataMatrices() const;
+
+  // Apply the pending public poses in the mailbox to the neighbor poses
+  void processPublicPosesMailbox();
 
   // Publish loop closures for visualization
   void storeLoopClosureMarkers();
@@ -317,12 +823,71 @@ class PGOAgentROS : public PGOAgent {
   // Initialize global anchor using stored information
   void initializeGlobalAnchor();
 
+  // Write the stored trajectory, neighbor poses, edge weights, lifting matrix and
+  // pose graph to the checkpoint file in a background thread
+  void saveCheckpoint();
+
+  // Restore the state saved by saveCheckpoint (called once at startup)
+  bool loadCheckpoint();
+
+  // Apply the weights of the measurements restored from the checkpoint to the current pose graph
+  void applyCheckpointWeights();
+
+  // Evaluate the residuals of active loop closures in parallel and reject (fix at zero weight)
+  // the ones whose weight falls below weightConvergenceThreshold.
+  // If responsible_only is true, skip shared loop closures whose weights are set by neighbors.
+  LoopClosureWeightStatistics rejectConvergedOutliers(bool responsible_only);
+
+  // Fix loop closure weights that stayed converged for weightFixingPatience weight updates.
+  // Return the number of fixed weights.
+  size_t fixConvergedWeights();
+
+  // Aggregated Riemannian gradient norm of active robots (infinity if a robot has not reported)
+  double globalGradNorm() const;
+
+  // Check if the current (inner) optimization loop has converged according to the
+  // predicted remaining cost decrease or the aggregated gradient norm (leader only)
+  bool predictedConvergence() const;
+
+  // Check if the loop closure weights of all active robots changed by less than
+  // weightConvergenceThreshold at the last weight update
+  bool teamWeightsSettled() const;
+
+  // Publish status, schedule the next update, or terminate after the local solve
+  void finishSynchronousIteration(bool success, bool schedule_next);
+
+  // Leader checks termination and weight updates before passing the turn; other robots pass the turn
+  void publishNextCommand();
+
+  // Finish the local solve on the worker thread
+  void finishLocalSolve();
+  void waitForLocalSolve();
+
+  // Queue a message callback while this robot waits for the pose graph of a new round, or
+  // if during_local_solve, while the local solve owns the state it touches (or earlier
+  // callbacks are still queued). Return true if queued.
+  bool deferCallback(std::function<void()> callback, bool during_local_solve);
+
+  // Run the queued callbacks in order, once the local solve and the pose graph query are done
+  void runDeferredCallbacks();
+
+  // Time budget (ms) of the next local solve, adapted to the median local solve time of the team
+  double localSolveTimeBudget() const;
+
+  // Change the relaxation rank between rounds. The pose graph is rebuilt, and the
+  // lifting matrix of the new rank is redistributed by the leader.
+  void setRelaxationRank(unsigned rank);
+
+  // Check if the converged team solution has full rank, in which case the relaxation
+  // rank should be increased (leader only)
+  bool relaxationRankIncreaseRequired();
+
   // Log iteration
   bool createIterationLog(const std::string &filename);
   bool logIteration();
   bool logString(const std::string &str);
 
-  // ROS callbacks
+  // Callbacks
   void connectivityCallback(const std_msgs::UInt16MultiArrayConstPtr &msg);
   void liftingMatrixCallback(const MatrixMsgConstPtr &msg);
   void anchorCallback(const PublicPosesConstPtr &msg);
@@ -331,35 +896,42 @@ class PGOAgentROS : public PGOAgent {
   void publicPosesCallback(const PublicPosesConstPtr &msg);
   void publicMeasurementsCallback(const RelativeMeasurementListConstPtr &msg);
   void measurementWeightsCallback(const RelativeMeasurementWeightsConstPtr &msg);
+  void startupTimerCallback(const ros::TimerEvent &event);
   void timerCallback(const ros::TimerEvent &event);
   void visualizationTimerCallback(const ros::TimerEvent &event);
+  void heartbeatTimerCallback(const ros::TimerEvent &event);
+  void onlineUpdateTimerCallback(const ros::TimerEvent &event);
+  void poseGraphSummaryTimerCallback(const ros::TimerEvent &event);
+
+  // Transport of messages exchanged with other agents
+  std::unique_ptr<PGOAgentTransport> mTransport;
+
+  // Sequence numbers, acknowledgements and retransmissions of commands
+  std::unique_ptr<CommandChannel> mCommandChannel;
 
   // ROS publisher
-  ros::Publisher mLiftingMatrixPublisher;
-  ros::Publisher mAnchorPublisher;
-  ros::Publisher mStatusPublisher;
-  ros::Publisher mCommandPublisher;
-  ros::Publisher mPublicPosesPublisher;
-  ros::Publisher mPublicMeasurementsPublisher;
-  ros::Publisher mMeasurementWeightsPublisher;
   ros::Publisher mPoseArrayPublisher;    // Publish optimized trajectory
   ros::Publisher mPathPublisher;         // Publish optimized trajectory
   ros::Publisher mPoseGraphPublisher;    // Publish optimized pose graph
   ros::Publisher mLoopClosureMarkerPublisher;  // Publish loop closures for visualization
 
   // ROS subscriber
-  SubscriberVector mLiftingMatrixSubscriber;
-  SubscriberVector mStatusSubscriber;
-  SubscriberVector mCommandSubscriber;
-  SubscriberVector mAnchorSubscriber;
-  SubscriberVector mPublicPosesSubscriber;
-  SubscriberVector mSharedLoopClosureSubscriber;
-  SubscriberVector mMeasurementWeightsSubscriber;
   ros::Subscriber mConnectivitySubscriber;
 
   // ROS timer
+  ros::Timer mStartupTimer;
   ros::Timer timer;
   ros::Timer mVisualizationTimer;
+
+  // Heartbeats are published from their own thread, so that they continue during local solves.
+  // The queue is declared first, so that it outlives the timer and the spinner that use it.
+  ros::CallbackQueue mHeartbeatQueue;
+  ros::Timer mHeartbeatTimer;
+  std::unique_ptr<ros::AsyncSpinner> mHeartbeatSpinner;
+  ros::Timer mOnlineUpdateTimer;
+  ros::Timer mPoseGraphSummaryTimer;
+  ros::Timer mResumeTimer;
+  ros::Timer mPublishResultsTimer;
 };
 
 }  // namespace dpgo_ros
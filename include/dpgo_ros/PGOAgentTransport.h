@@ -0,0 +1,61 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <dpgo_ros/Command.h>
+#include <dpgo_ros/MatrixMsg.h>
+#include <dpgo_ros/PublicPoses.h>
+#include <dpgo_ros/RelativeMeasurementList.h>
+#include <dpgo_ros/RelativeMeasurementWeights.h>
+#include <dpgo_ros/Status.h>
+#include <ros/time.h>
+
+#include <functional>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Callbacks for the messages an agent receives from a teammate.
+ * Unset callbacks are not subscribed.
+ */
+struct PGOAgentMessageHandlers {
+  std::function<void(const CommandConstPtr &)> command;
+  std::function<void(const StatusConstPtr &)> status;
+  std::function<void(const PublicPosesConstPtr &)> public_poses;
+  std::function<void(const PublicPosesConstPtr &)> anchor;
+  std::function<void(const MatrixMsgConstPtr &)> lifting_matrix;
+  std::function<void(const RelativeMeasurementListConstPtr &)> public_measurements;
+  std::function<void(const RelativeMeasurementWeightsConstPtr &)> measurement_weights;
+  // Called right before the command and status callbacks with the time the message arrived,
+  // which is earlier than the callback when the receiving thread was busy
+  std::function<void(const ros::Time &)> arrival;
+};
+
+/**
+ * @brief Abstract transport for the messages exchanged between agents during
+ * distributed optimization. Published messages must not be modified afterwards,
+ * as implementations may hand the same object to local subscribers.
+ */
+class PGOAgentTransport {
+ public:
+  virtual ~PGOAgentTransport() = default;
+
+  // Publish messages of this agent
+  virtual void publishCommand(const CommandConstPtr &msg) = 0;
+  virtual void publishStatus(const StatusConstPtr &msg) = 0;
+  virtual void publishPublicPoses(const PublicPosesConstPtr &msg) = 0;
+  virtual void publishAnchor(const PublicPosesConstPtr &msg) = 0;
+  virtual void publishLiftingMatrix(const MatrixMsgConstPtr &msg) = 0;
+  virtual void publishPublicMeasurements(const RelativeMeasurementListConstPtr &msg) = 0;
+  virtual void publishMeasurementWeights(const RelativeMeasurementWeightsConstPtr &msg) = 0;
+
+  // Receive messages published by the agent with the given ID
+  virtual void subscribe(unsigned robot_id, const PGOAgentMessageHandlers &handlers) = 0;
+};
+
+}  // namespace dpgo_ros
@@ -0,0 +1,56 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <dpgo_ros/PGOAgentTransport.h>
+#include <ros/ros.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Transport over roscpp topics. Messages of robot i are published under
+ * /<name of robot i>/dpgo_ros_node/. Messages of other robots are received from
+ * <topic_prefix>/<name of robot j>/dpgo_ros_node/.
+ */
+class ROSTransport : public PGOAgentTransport {
+ public:
+  ROSTransport(const ros::NodeHandle &nh_,
+               const std::map<unsigned, std::string> &robot_names,
+               const std::string &topic_prefix = "");
+
+  void publishCommand(const CommandConstPtr &msg) override;
+  void publishStatus(const StatusConstPtr &msg) override;
+  void publishPublicPoses(const PublicPosesConstPtr &msg) override;
+  void publishAnchor(const PublicPosesConstPtr &msg) override;
+  void publishLiftingMatrix(const MatrixMsgConstPtr &msg) override;
+  void publishPublicMeasurements(const RelativeMeasurementListConstPtr &msg) override;
+  void publishMeasurementWeights(const RelativeMeasurementWeightsConstPtr &msg) override;
+
+  void subscribe(unsigned robot_id, const PGOAgentMessageHandlers &handlers) override;
+
+ private:
+  ros::NodeHandle nh;
+  std::map<unsigned, std::string> mRobotNames;
+  std::string mTopicPrefix;
+
+  ros::Publisher mLiftingMatrixPublisher;
+  ros::Publisher mAnchorPublisher;
+  ros::Publisher mStatusPublisher;
+  ros::Publisher mCommandPublisher;
+  ros::Publisher mPublicPosesPublisher;
+  ros::Publisher mPublicMeasurementsPublisher;
+  ros::Publisher mMeasurementWeightsPublisher;
+
+  std::vector<ros::Subscriber> mSubscribers;
+};
+
+}  // namespace dpgo_ros
@@ -0,0 +1,67 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+
+#include <vector>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+/**
+ * @brief Parameters of a synthetic multi-robot pose graph
+ */
+struct SyntheticDatasetParameters {
+  // Dimension (2 or 3)
+  unsigned d = 3;
+  unsigned numRobots = 5;
+  unsigned numPosesPerRobot = 1000;
+  // Robots move on a grid with numCellsPerSide cells along each axis (one layer in 2D)
+  unsigned numCellsPerSide = 20;
+  // Probability of turning at each step
+  double turnProbability = 0.3;
+  // Probability of adding a loop closure when revisiting a cell visited by the same robot
+  double intraLoopClosureProbability = 0.1;
+  // Probability of adding a loop closure when visiting a cell visited by another robot
+  double interLoopClosureProbability = 0.1;
+  // Standard deviations of the measurement noise (radians and meters)
+  double rotationNoiseStd = 0.01;
+  double translationNoiseStd = 0.05;
+  // Fraction of loop closures replaced by random measurements
+  double outlierFraction = 0;
+  unsigned seed = 0;
+  // Store the ground truth trajectories in the output
+  bool storeGroundTruth = false;
+};
+
+/**
+ * @brief Synthetic multi-robot pose graph
+ */
+struct SyntheticDataset {
+  // Measurements of each robot. Shared loop closures are included for both robots.
+  std::vector<std::vector<RelativeSEMeasurement>> measurements;
+  // Ground truth trajectory of each robot (only if storeGroundTruth is set)
+  std::vector<PoseArray> groundTruth;
+  size_t numIntraLoopClosures = 0;
+  size_t numInterLoopClosures = 0;
+  size_t numOutliers = 0;
+};
+
+/**
+ * @brief Generate a synthetic multi-robot pose graph. All robots explore a shared
+ * grid world simultaneously, and loop closures are added when a robot visits a cell
+ * that has been visited before. The output is deterministic given the seed.
+ * @param params
+ * @return
+ */
+SyntheticDataset generateSyntheticDataset(const SyntheticDatasetParameters &params);
+
+}  // namespace dpgo_ros
@@ -0,0 +1,86 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+
+#include <vector>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+/**
+ * @brief Correspondence between the poses of a robot and the poses kept in its reduced pose graph
+ */
+struct ChainReduction {
+  // Full index of each pose kept in the reduced graph
+  std::vector<unsigned> keptPoses;
+  // Reduced index of each pose in the full graph (-1 if the pose is removed)
+  std::vector<int> reducedIndices;
+  // Odometry of the full graph, where odometry[i] connects pose i and i + 1
+  std::vector<RelativeSEMeasurement> odometry;
+
+  unsigned numPoses() const { return reducedIndices.size(); }
+  unsigned numKeptPoses() const { return keptPoses.size(); }
+  // Index in the full graph of a pose in the reduced graph
+  unsigned fullIndex(unsigned reduced_index) const { return keptPoses[reduced_index]; }
+  // Index in the reduced graph of a pose in the full graph (-1 if removed or out of range)
+  int reducedIndex(unsigned full_index) const {
+    return full_index < reducedIndices.size() ? reducedIndices[full_index] : -1;
+  }
+};
+
+/**
+ * @brief Collapse chains of odometry into composed measurements between kept poses.
+ * The kept poses are the first and last poses, the endpoints of loop closures, poses
+ * next to missing odometry, and every keyframe_interval-th pose. A pose is also kept
+ * between the endpoints of a private loop closure that would otherwise become consecutive,
+ * so that consecutive reduced indices are always connected by the composed odometry only.
+ * @param robot_id
+ * @param measurements measurements of this robot, indexed in the full graph
+ * @param keyframe_interval (0 to only keep required poses)
+ * @param reduction output correspondence between the full and reduced graphs
+ * @return measurements of the reduced graph. Poses of this robot use reduced indices,
+ * and poses of other robots keep their indices.
+ */
+std::vector<RelativeSEMeasurement> reduceOdometryChains(unsigned robot_id,
+                                                        const std::vector<RelativeSEMeasurement> &measurements,
+                                                        unsigned keyframe_interval,
+                                                        ChainReduction &reduction);
+
+/**
+ * @brief Map a measurement of the reduced graph to the indices of the full graph
+ * @param robot_id
+ * @param reduction
+ * @param m measurement of the reduced graph
+ * @return measurement whose poses of this robot use full indices
+ */
+RelativeSEMeasurement expandMeasurement(unsigned robot_id, const ChainReduction &reduction,
+                                        const RelativeSEMeasurement &m);
+
+/**
+ * @brief Map a measurement of the full graph to the indices of the reduced graph
+ * @param robot_id
+ * @param reduction
+ * @param m measurement of the full graph, overwritten with the reduced indices
+ * @return false if a pose of this robot is removed by the reduction
+ */
+bool reduceMeasurement(unsigned robot_id, const ChainReduction &reduction, RelativeSEMeasurement &m);
+
+/**
+ * @brief Recover the full trajectory from the poses of the reduced graph by propagating odometry
+ * from each kept pose. The mismatch with the next kept pose is distributed along the chain.
+ * @param reduction
+ * @param reduced_poses
+ * @return
+ */
+PoseArray expandTrajectory(const ChainReduction &reduction, const PoseArray &reduced_poses);
+
+}  // namespace dpgo_ros
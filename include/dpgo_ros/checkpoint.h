@@ -0,0 +1,61 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+/**
+ * @brief State of an agent that survives a process restart
+ */
+struct AgentCheckpoint {
+  unsigned robot_id = 0;
+  unsigned d = 0;
+  unsigned r = 0;
+  // Optimized trajectory in the global frame
+  std::optional<PoseArray> poses;
+  // Neighbor poses in the global frame
+  std::map<PoseID, Pose, ComparePoseID> neighbor_poses;
+  // Weights of shared loop closures
+  std::unordered_map<EdgeID, double, HashEdgeID> edge_weights;
+  // Lifting matrix shared by the team
+  std::optional<Matrix> lifting_matrix;
+  // Measurements of the local pose graph (including their current weights)
+  std::vector<RelativeSEMeasurement> measurements;
+};
+
+/**
+ * @brief Write checkpoint to a binary file. The file is first written to a
+ * temporary path, flushed to disk and then renamed, so that a crash never leaves
+ * a partial checkpoint.
+ * @param path
+ * @param checkpoint
+ * @return true if the checkpoint is written successfully
+ */
+bool writeCheckpoint(const std::string &path, const AgentCheckpoint &checkpoint);
+
+/**
+ * @brief Read checkpoint from a binary file written by writeCheckpoint. Fails if the
+ * file is truncated, or if its sizes are inconsistent with the stored dimensions.
+ * @param path
+ * @param checkpoint
+ * @return true if the checkpoint is read successfully
+ */
+bool readCheckpoint(const std::string &path, AgentCheckpoint &checkpoint);
+
+}  // namespace dpgo_ros
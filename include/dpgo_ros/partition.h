@@ -0,0 +1,68 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+
+#include <vector>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+/**
+ * @brief Assignment of the poses of a single-robot dataset to robots
+ */
+struct PosePartition {
+  // Robot and local pose ID of each pose in the dataset
+  std::vector<PoseID> poseIDs;
+  // Number of poses with at least one measurement to another robot
+  size_t numSharedPoses = 0;
+  // Number of measurements between different robots
+  size_t numSharedEdges = 0;
+};
+
+/**
+ * @brief Parameters of the min edge cut partitioner
+ */
+struct PartitionParameters {
+  // The trajectory is cut into this many chunks of consecutive poses per robot,
+  // and robots are separated at chunk boundaries
+  unsigned numChunksPerRobot = 16;
+  // Maximum relative deviation of the number of poses of a robot from the average
+  double maxImbalance = 0.1;
+};
+
+/**
+ * @brief Assign consecutive pose indices of equal size to each robot
+ * @param num_poses
+ * @param num_robots
+ * @param measurements measurements between poses of the dataset (r1 and r2 are ignored)
+ * @return
+ */
+PosePartition partitionContiguous(size_t num_poses, unsigned num_robots,
+                                  const std::vector<RelativeSEMeasurement> &measurements);
+
+/**
+ * @brief Assign a range of consecutive poses to each robot, with the cuts between
+ * robots chosen to minimize the number of measurements between different robots
+ * while keeping the robots balanced. Ranges are contiguous so that consecutive local
+ * pose IDs always correspond to odometry of the dataset. Falls back to the contiguous
+ * partition of equal size if no cut at chunk boundaries satisfies the balance constraint.
+ * @param num_poses
+ * @param num_robots
+ * @param measurements measurements between poses of the dataset (r1 and r2 are ignored)
+ * @param params
+ * @return
+ */
+PosePartition partitionMinEdgeCut(size_t num_poses, unsigned num_robots,
+                                  const std::vector<RelativeSEMeasurement> &measurements,
+                                  const PartitionParameters &params = PartitionParameters());
+
+}  // namespace dpgo_ros
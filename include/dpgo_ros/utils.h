@@ -21,6 +21,7 @@
 #include <tf/tf.h>
 
 #include <cassert>
+#include <cstdint>
 #include <fstream>
 #include <vector>
 
@@ -47,11 +48,44 @@ Write a matrix to ROS message
 */
 MatrixMsg MatrixToMsg(const Matrix &Mat);
 
+/**
+Write a matrix to an existing ROS message, reusing its storage when the size matches
+*/
+void MatrixToMsg(const Matrix &Mat, MatrixMsg &msg);
+
 /**
 Read a matrix from ROS message
 */
 Matrix MatrixFromMsg(const MatrixMsg &msg);
 
+/**
+ * @brief Retrieve rotation matrix from geometry_msgs::Pose (fixed-size version for d = 3)
+ * @param msg
+ * @return
+ */
+Eigen::Matrix3d RotationFromPoseMsg3d(const geometry_msgs::Pose &msg);
+
+/**
+ * @brief Retrieve translation vector from geometry_msgs::Pose (fixed-size version for d = 3)
+ * @param msg
+ * @return
+ */
+Eigen::Vector3d TranslationFromPoseMsg3d(const geometry_msgs::Pose &msg);
+
+/**
+ * @brief Convert a rotation matrix to quaternion message (fixed-size version for d = 3)
+ * @param R
+ * @return
+ */
+geometry_msgs::Quaternion RotationToQuaternionMsg3d(const Eigen::Matrix3d &R);
+
+/**
+ * @brief Convert a translation vector to point message (fixed-size version for d = 3)
+ * @param t
+ * @return
+ */
+geometry_msgs::Point TranslationToPointMsg3d(const Eigen::Vector3d &t);
+
 /**
  * @brief Retrieve 3-by-3 rotation matrix from geometry_msgs::Pose
  * @param msg
@@ -90,6 +124,22 @@ Read a relative measurement from ROS message
 */
 RelativeSEMeasurement RelativeMeasurementFromMsg(const PoseGraphEdge &msg);
 
+/**
+Append relative measurements to an array of ROS messages
+*/
+void RelativeMeasurementsToMsg(const std::vector<RelativeSEMeasurement> &measurements,
+                               std::vector<PoseGraphEdge> &edges);
+
+/**
+Read relative measurements from an array of ROS messages
+*/
+std::vector<RelativeSEMeasurement> RelativeMeasurementsFromMsg(const std::vector<PoseGraphEdge> &edges);
+
+/**
+Convert an aggregate matrix T \in (SO(3) \times R3)^n to an array of ROS poses
+*/
+std::vector<geometry_msgs::Pose> TrajectoryToPoseMsgs(unsigned n, const Matrix &T);
+
 /**
 Convert an aggregate matrix T \in (SO(d) \times Rd)^n to a ROS PoseArray message
 */
@@ -139,8 +189,123 @@ Status statusToMsg(const PGOAgentStatus &status);
 PGOAgentStatus statusFromMsg(const Status &msg);
 
 /**
- * @brief Sleep for a time randomly distributed in [min_sec, max_sec]
+ * @brief Number of edges and loop closures in a pose graph message
+ */
+struct PoseGraphSummary {
+  unsigned numEdges = 0;
+  // Shared loop closures are only counted by the robot with the smaller ID
+  unsigned numLoopClosures = 0;
+};
+
+/**
+ * @brief Summarize the pose graph of a robot
+ * @param pose_graph
+ * @param robot_id
+ * @return
+ */
+PoseGraphSummary summarizePoseGraph(const pose_graph_tools::PoseGraph &pose_graph, unsigned robot_id);
+
+/**
+ * @brief Append poses to a (lifted) trajectory by composing odometry measurements,
+ * starting from its current last pose. Poses without incoming odometry copy the previous pose.
+ * @param X trajectory to extend
+ * @param n number of poses after extension
+ * @param odometry odometry measurements of this robot
+ */
+void extendTrajectoryByOdometry(LiftedPoseArray &X, unsigned n,
+                                const std::vector<RelativeSEMeasurement> &odometry);
+
+/**
+ * @brief Sum of Y_i * Y_i^T over the lifted rotations Y_i of a trajectory
+ * @param X lifted trajectory
+ * @return r-by-r positive semidefinite matrix, which can be summed over robots
+ */
+Matrix liftedRotationGram(const LiftedPoseArray &X);
+
+/**
+ * @brief Ratio between the (d+1)-th largest and the largest eigenvalue of the Gram
+ * matrix of the lifted rotations. The lifted solution has rank d (and is exactly rounded)
+ * if the ratio is zero.
+ * @param gram r-by-r Gram matrix
+ * @param d
+ * @return
+ */
+double liftedRankRatio(const Matrix &gram, unsigned d);
+
+/**
+ * @brief Latest local optimization of a robot, as reported in its status
+ */
+struct RobotUpdateStatistics {
+  // Whether the robot has reported a local optimization in this round
+  bool valid = false;
+  // Cost decrease of the latest local optimization
+  double costDecrease = 0;
+  // Wall time of the latest local optimization
+  double elapsedMs = 0;
+  // Number of iterations since the latest local optimization
+  unsigned staleness = 0;
+};
+
+/**
+ * @brief Sampling weights for the next robot to update, proportional to the expected cost
+ * decrease per second. The expected decrease of a robot is its latest decrease, scaled down
+ * if fewer than stats.size() iterations have passed since then. Robots without statistics
+ * get the largest weight, and every weight is at least min_weight_ratio times the largest.
+ * @param stats
+ * @param min_weight_ratio
+ * @return
+ */
+std::vector<double> loadBalancedUpdateWeights(const std::vector<RobotUpdateStatistics> &stats,
+                                              double min_weight_ratio);
+
+/**
+ * @brief Differences between two sets of measurements
+ */
+struct MeasurementChanges {
+  // Measurements that only appear in the current set
+  size_t numAdded = 0;
+  // Measurements that only appear in the previous set
+  size_t numRemoved = 0;
+  // Measurements in both sets with a different weight or value
+  size_t numModified = 0;
+
+  bool empty() const { return numAdded == 0 && numRemoved == 0 && numModified == 0; }
+};
+
+/**
+ * @brief Compare two sets of measurements by their edges
+ * @param previous
+ * @param current
+ * @return
+ */
+MeasurementChanges compareMeasurements(const std::vector<RelativeSEMeasurement> &previous,
+                                       const std::vector<RelativeSEMeasurement> &current);
+
+/**
+ * @brief Robot designated to take over if the leader fails, i.e., the lowest ID active
+ * robot other than the leader. All robots that know the active robots agree on it.
+ * @param leader_id
+ * @param active_robots
+ * @return active_robots.size() if there is no successor
+ */
+unsigned leaderSuccessor(unsigned leader_id, const std::vector<bool> &active_robots);
+
+/**
+ * @brief Follow a TAKEOVER command if it comes from the successor of the current leader.
+ * The failed leader is deactivated, which also deactivates a leader that was falsely
+ * suspected to fail when it receives the command of its successor.
+ * @param new_leader robot that published the command
+ * @param command_cluster_id cluster ID of the command
+ * @param leader_id current leader, set to new_leader if the command is accepted
+ * @param active_robots active robots, updated if the command is accepted
+ * @return false if the command is rejected
+ */
+bool followLeaderTakeover(unsigned new_leader, unsigned command_cluster_id,
+                          unsigned &leader_id, std::vector<bool> &active_robots);
+
+/**
+ * @brief Duration randomly distributed in [min_sec, max_sec]
  */
-void randomSleep(double min_sec, double max_sec);
+ros::Duration randomDuration(double min_sec, double max_sec);
 
 }  // namespace dpgo_ros
@@ -0,0 +1,136 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/CommandChannel.h>
+
+#include <algorithm>
+
+namespace dpgo_ros {
+
+bool CommandSequenceWindow::receive(uint32_t epoch, uint32_t seq) {
+  if (seq == 0) return true;
+  if (epoch != mEpoch) {
+    mEpoch = epoch;
+    mHighest = 0;
+    mMask = 0;
+  }
+  if (seq > mHighest) {
+    const uint32_t shift = seq - mHighest;
+    if (mHighest == 0 || shift > kWindowSize) {
+      mMask = 0;
+    } else {
+      mMask = (shift == kWindowSize) ? 0 : mMask << shift;
+      mMask |= 1ULL << (shift - 1);
+    }
+    mHighest = seq;
+    return true;
+  }
+  if (seq == mHighest) return false;
+  const uint32_t offset = mHighest - 1 - seq;
+  if (offset >= kWindowSize) return false;
+  const uint64_t bit = 1ULL << offset;
+  if (mMask & bit) return false;
+  mMask |= bit;
+  return true;
+}
+
+bool CommandSequenceWindow::acknowledges(uint32_t highest, uint64_t mask, uint32_t seq) {
+  if (seq == 0 || seq > highest) return false;
+  if (seq == highest) return true;
+  const uint32_t offset = highest - 1 - seq;
+  return offset < kWindowSize && ((mask >> offset) & 1ULL);
+}
+
+CommandChannel::CommandChannel(unsigned robot_id, unsigned num_robots, uint32_t epoch,
+                               PGOAgentTransport &transport)
+    : mRobotID(robot_id), mEpoch(epoch), mTransport(transport), mReceivedCommands(num_robots) {}
+
+void CommandChannel::publish(const CommandPtr &msg, const std::vector<unsigned> &recipients, double time) {
+  msg->sequence_number = ++mSequence;
+  msg->sender_epoch = mEpoch;
+  PendingCommand pending;
+  pending.msg = msg;
+  pending.last_sent = time;
+  for (unsigned robot_id : recipients) {
+    if (robot_id != mRobotID) pending.unacked_robots.push_back(robot_id);
+  }
+  mTransport.publishCommand(msg);
+  if (!pending.unacked_robots.empty()) mPendingCommands.push_back(std::move(pending));
+}
+
+bool CommandChannel::receive(const Command &msg) {
+  if (msg.sequence_number == 0 || msg.publishing_robot >= mReceivedCommands.size()) return true;
+  return mReceivedCommands[msg.publishing_robot].receive(msg.sender_epoch, msg.sequence_number);
+}
+
+void CommandChannel::acknowledge(const Status &msg) {
+  const auto &ack_sequence = msg.command_ack_sequence;
+  const auto &ack_mask = msg.command_ack_mask;
+  const auto &ack_epoch = msg.command_ack_epoch;
+  if (mRobotID >= ack_sequence.size() || mRobotID >= ack_mask.size() || mRobotID >= ack_epoch.size()) return;
+  // Acknowledgements of the commands published before a restart
+  if (ack_epoch[mRobotID] != mEpoch) return;
+  for (auto it = mPendingCommands.begin(); it != mPendingCommands.end();) {
+    auto &robots = it->unacked_robots;
+    if (CommandSequenceWindow::acknowledges(ack_sequence[mRobotID], ack_mask[mRobotID],
+                                            it->msg->sequence_number)) {
+      robots.erase(std::remove(robots.begin(), robots.end(), msg.robot_id), robots.end());
+    }
+    it = robots.empty() ? mPendingCommands.erase(it) : it + 1;
+  }
+}
+
+void CommandChannel::fillAcknowledgements(Status &msg) const {
+  msg.command_ack_sequence.resize(mReceivedCommands.size());
+  msg.command_ack_mask.resize(mReceivedCommands.size());
+  msg.command_ack_epoch.resize(mReceivedCommands.size());
+  for (size_t robot_id = 0; robot_id < mReceivedCommands.size(); ++robot_id) {
+    msg.command_ack_sequence[robot_id] = mReceivedCommands[robot_id].highest();
+    msg.command_ack_mask[robot_id] = mReceivedCommands[robot_id].mask();
+    msg.command_ack_epoch[robot_id] = mReceivedCommands[robot_id].epoch();
+  }
+}
+
+std::vector<CommandRetransmission> CommandChannel::retransmit(double time, double ack_timeout,
+                                                              unsigned max_retransmissions,
+                                                              const std::function<bool(unsigned)> &is_active) {
+  std::vector<CommandRetransmission> retransmissions;
+  for (auto it = mPendingCommands.begin(); it != mPendingCommands.end();) {
+    PendingCommand &pending = *it;
+    auto &robots = pending.unacked_robots;
+    robots.erase(std::remove_if(robots.begin(), robots.end(),
+                                [&](unsigned robot_id) { return !is_active(robot_id); }),
+                 robots.end());
+    if (robots.empty()) {
+      it = mPendingCommands.erase(it);
+      continue;
+    }
+    if (time - pending.last_sent < ack_timeout) {
+      ++it;
+      continue;
+    }
+    CommandRetransmission retransmission;
+    retransmission.msg = pending.msg;
+    retransmission.num_unacked_robots = robots.size();
+    if (pending.num_retransmissions >= max_retransmissions) {
+      retransmission.num_retransmissions = pending.num_retransmissions;
+      retransmission.abandoned = true;
+      retransmissions.push_back(retransmission);
+      it = mPendingCommands.erase(it);
+      continue;
+    }
+    pending.num_retransmissions++;
+    pending.last_sent = time;
+    retransmission.num_retransmissions = pending.num_retransmissions;
+    retransmissions.push_back(retransmission);
+    mTransport.publishCommand(pending.msg);
+    ++it;
+  }
+  return retransmissions;
+}
+
+}  // namespace dpgo_ros
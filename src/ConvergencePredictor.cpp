@@ -0,0 +1,70 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/ConvergencePredictor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dpgo_ros {
+
+ConvergencePredictor::ConvergencePredictor(unsigned window)
+    : mWindow(std::max(1u, window)) {}
+
+void ConvergencePredictor::reset() {
+  mDecreases.clear();
+  mTotalDecrease = 0;
+}
+
+void ConvergencePredictor::addCostDecrease(unsigned iteration, double decrease) {
+  if (!std::isfinite(decrease)) return;
+  if (mDecreases.emplace(iteration, decrease).second) {
+    mTotalDecrease += decrease;
+  }
+}
+
+double ConvergencePredictor::windowDecrease(unsigned first, unsigned last) const {
+  double sum = 0;
+  for (auto it = mDecreases.upper_bound(first); it != mDecreases.end() && it->first <= last; ++it) {
+    sum += it->second;
+  }
+  return sum;
+}
+
+std::optional<double> ConvergencePredictor::convergenceRate() const {
+  if (mDecreases.empty()) return std::nullopt;
+  const unsigned last = mDecreases.rbegin()->first;
+  const unsigned first = mDecreases.begin()->first;
+  // Both windows must lie after the first recorded iteration
+  if (last < first + 2 * mWindow - 1) return std::nullopt;
+  const double previous = windowDecrease(last - 2 * mWindow, last - mWindow);
+  const double recent = windowDecrease(last - mWindow, last);
+  // The cost has stopped decreasing
+  if (previous <= 0) {
+    if (recent <= 0) return 0.0;
+    return std::nullopt;
+  }
+  return std::pow(std::max(recent, 0.0) / previous, 1.0 / mWindow);
+}
+
+double ConvergencePredictor::predictedRemainingDecrease() const {
+  const auto rate = convergenceRate();
+  if (!rate || rate.value() >= 1) return std::numeric_limits<double>::infinity();
+  const unsigned last = mDecreases.rbegin()->first;
+  const double recent = std::max(windowDecrease(last - mWindow, last), 0.0);
+  // Geometric series of future windows
+  const double window_rate = std::pow(rate.value(), mWindow);
+  return recent * window_rate / (1 - window_rate);
+}
+
+bool ConvergencePredictor::converged(double tolerance) const {
+  if (mTotalDecrease <= 0) return false;
+  return predictedRemainingDecrease() <= tolerance * mTotalDecrease;
+}
+
+}  // namespace dpgo_ros
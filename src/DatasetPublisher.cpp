@@ -0,0 +1,202 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_utils.h>
+#include <dpgo_ros/DatasetPublisher.h>
+#include <dpgo_ros/SyntheticDataset.h>
+#include <dpgo_ros/partition.h>
+#include <dpgo_ros/utils.h>
+
+#include <algorithm>
+#include <map>
+
+using std::map;
+using std::string;
+using std::vector;
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+DatasetPublisher::DatasetPublisher(const ros::NodeHandle &nh_, const ros::NodeHandle &nh_private_)
+    : nh(nh_), nh_private(nh_private_), num_robots(0) {
+  if (!nh_private.getParam("num_robots", num_robots)) {
+    ROS_ERROR_STREAM("Failed to get number of robots!");
+  }
+
+  // Load robot names
+  for (size_t id = 0; id < (unsigned) num_robots; id++) {
+    std::string robot_name = "kimera" + std::to_string(id);
+    nh_private.getParam("robot" + std::to_string(id) + "_name", robot_name);
+    robotNames[id] = robot_name;
+  }
+
+  string filename;
+  bool synthetic = false;
+  nh_private.getParam("synthetic", synthetic);
+  if (synthetic) {
+    // Generate a synthetic dataset
+    loadFromSynthetic();
+  } else if (nh_private.getParam("g2o_file", filename)) {
+    // Load from single g2o file
+    loadFromG2O(filename);
+  } else {
+    // Load num_robots measurements.csv
+    loadFromMeasurements();
+  }
+
+  for (size_t id = 0; id < (unsigned) num_robots; ++id) {
+    string service_name = "/" + robotNames.at(id) + "/distributed_loop_closure/request_pose_graph";
+    ros::ServiceServer server = nh.advertiseService(
+        service_name, &DatasetPublisher::queryPoseGraphCallback, this);
+    poseGraphServers.push_back(server);
+  }
+}
+
+bool DatasetPublisher::queryPoseGraphCallback(
+    pose_graph_tools::PoseGraphQueryRequest &request,
+    pose_graph_tools::PoseGraphQueryResponse &response) {
+  if (request.robot_id >= poseGraphs.size()) {
+    ROS_ERROR("DatasetPublisher: requested robot does not exist!");
+    return false;
+  }
+  ROS_INFO("Received request from robot %i.", request.robot_id);
+  response.pose_graph = poseGraphs[request.robot_id];
+  return true;
+}
+
+void DatasetPublisher::loadFromG2O(const std::string &filename) {
+  size_t num_poses;
+  vector<RelativeSEMeasurement> dataset = read_g2o_file(filename, num_poses);
+  ROS_INFO_STREAM("Loaded dataset" << filename << " with " << num_poses
+                                   << " total poses.");
+  unsigned int n = num_poses;
+  unsigned int num_poses_per_robot = n / num_robots;
+  if (num_poses_per_robot <= 0) {
+    ROS_ERROR_STREAM(
+        "Number of robots must be smaller than total number of poses!");
+  }
+
+  ROS_INFO_STREAM(
+      "Creating mapping from global pose index to local pose index...");
+  string partition_method = "contiguous";
+  nh_private.getParam("partition_method", partition_method);
+  PosePartition partition;
+  if (partition_method == "min_edge_cut") {
+    PartitionParameters partition_params;
+    int num_chunks_per_robot = partition_params.numChunksPerRobot;
+    nh_private.getParam("partition_chunks_per_robot", num_chunks_per_robot);
+    nh_private.getParam("partition_max_imbalance", partition_params.maxImbalance);
+    partition_params.numChunksPerRobot = std::max(1, num_chunks_per_robot);
+    partition = partitionMinEdgeCut(n, num_robots, dataset, partition_params);
+  } else {
+    if (partition_method != "contiguous")
+      ROS_WARN_STREAM("Unknown partition method " << partition_method << ", using contiguous partition.");
+    partition = partitionContiguous(n, num_robots, dataset);
+  }
+  ROS_INFO("Partitioned dataset with %zu shared poses and %zu shared edges.",
+           partition.numSharedPoses, partition.numSharedEdges);
+  const vector<PoseID> &PoseMap = partition.poseIDs;
+
+  vector<vector<RelativeSEMeasurement>> odometry(num_robots);
+  vector<vector<RelativeSEMeasurement>> private_loop_closures(num_robots);
+  vector<vector<RelativeSEMeasurement>> shared_loop_closure(num_robots);
+  for (size_t k = 0; k < dataset.size(); ++k) {
+    RelativeSEMeasurement mIn = dataset[k];
+    const PoseID &src = PoseMap[mIn.p1];
+    const PoseID &dst = PoseMap[mIn.p2];
+
+    unsigned srcRobot = src.robot_id;
+    unsigned srcIdx = src.frame_id;
+    unsigned dstRobot = dst.robot_id;
+    unsigned dstIdx = dst.frame_id;
+
+    RelativeSEMeasurement m(srcRobot, dstRobot, srcIdx, dstIdx, mIn.R, mIn.t,
+                            mIn.kappa, mIn.tau);
+
+    if (srcRobot == dstRobot) {
+      // private measurement
+      if (srcIdx + 1 == dstIdx) {
+        // Odometry
+        odometry[srcRobot].push_back(m);
+      } else {
+        // private loop closure
+        private_loop_closures[srcRobot].push_back(m);
+      }
+    } else {
+      // shared measurement
+      shared_loop_closure[srcRobot].push_back(m);
+      // shared_loop_closure[dstRobot].push_back(m);
+    }
+  }
+
+  for (size_t robot = 0; robot < (unsigned) num_robots; ++robot) {
+    pose_graph_tools::PoseGraph pose_graph;
+    // Add odometry factors
+    dpgo_ros::RelativeMeasurementsToMsg(odometry[robot], pose_graph.edges);
+    // Add private loop closures
+    dpgo_ros::RelativeMeasurementsToMsg(private_loop_closures[robot], pose_graph.edges);
+    // Add shared loop closures
+    dpgo_ros::RelativeMeasurementsToMsg(shared_loop_closure[robot], pose_graph.edges);
+    poseGraphs.push_back(pose_graph);
+  }
+}
+
+void DatasetPublisher::loadFromSynthetic() {
+  // Pose graph messages only support 3D measurements
+  SyntheticDatasetParameters params;
+  params.d = 3;
+  params.numRobots = num_robots;
+  int num_poses_per_robot = params.numPosesPerRobot;
+  int num_cells_per_side = params.numCellsPerSide;
+  int seed = params.seed;
+  nh_private.getParam("synthetic_dataset/num_poses_per_robot", num_poses_per_robot);
+  nh_private.getParam("synthetic_dataset/num_cells_per_side", num_cells_per_side);
+  nh_private.getParam("synthetic_dataset/turn_probability", params.turnProbability);
+  nh_private.getParam("synthetic_dataset/intra_loop_closure_probability", params.intraLoopClosureProbability);
+  nh_private.getParam("synthetic_dataset/inter_loop_closure_probability", params.interLoopClosureProbability);
+  nh_private.getParam("synthetic_dataset/rotation_noise_std", params.rotationNoiseStd);
+  nh_private.getParam("synthetic_dataset/translation_noise_std", params.translationNoiseStd);
+  nh_private.getParam("synthetic_dataset/outlier_fraction", params.outlierFraction);
+  nh_private.getParam("synthetic_dataset/seed", seed);
+  if (num_poses_per_robot <= 1 || num_cells_per_side <= 1) {
+    ROS_ERROR("DatasetPublisher: invalid synthetic dataset parameters!");
+    return;
+  }
+  params.numPosesPerRobot = num_poses_per_robot;
+  params.numCellsPerSide = num_cells_per_side;
+  params.seed = seed;
+
+  SyntheticDataset dataset = generateSyntheticDataset(params);
+  ROS_INFO("Generated synthetic dataset with %i robots x %u poses, %zu private and %zu shared loop closures "
+           "(%zu outliers).",
+           num_robots, params.numPosesPerRobot, dataset.numIntraLoopClosures,
+           dataset.numInterLoopClosures, dataset.numOutliers);
+
+  for (size_t robot = 0; robot < (unsigned) num_robots; ++robot) {
+    pose_graph_tools::PoseGraph pose_graph;
+    dpgo_ros::RelativeMeasurementsToMsg(dataset.measurements[robot], pose_graph.edges);
+    // Release measurements as soon as they are converted
+    std::vector<RelativeSEMeasurement>().swap(dataset.measurements[robot]);
+    poseGraphs.push_back(pose_graph);
+  }
+}
+
+void DatasetPublisher::loadFromMeasurements() {
+  for (size_t robot_id = 0; robot_id < (unsigned) num_robots; ++robot_id) {
+    pose_graph_tools::PoseGraph pose_graph;
+    std::string measurement_file;
+    if (!nh_private.getParam("robot" + std::to_string(robot_id) + "_measurements", measurement_file)) {
+      ROS_ERROR("No measurement file specified for robot %zu!", robot_id);
+    }
+    std::vector<RelativeSEMeasurement> measurements = PGOLogger::loadMeasurements(measurement_file,
+                                                                                  false);
+    dpgo_ros::RelativeMeasurementsToMsg(measurements, pose_graph.edges);
+    poseGraphs.push_back(pose_graph);
+  }
+}
+
+}  // namespace dpgo_ros
@@ -0,0 +1,68 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/FailureDetector.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace dpgo_ros {
+
+PhiAccrualDetector::PhiAccrualDetector(double first_interval, double acceptable_pause,
+                                       double min_std_dev, size_t window_size)
+    : mFirstInterval(first_interval),
+      mAcceptablePause(acceptable_pause),
+      mMinStdDev(min_std_dev),
+      mWindowSize(std::max<size_t>(window_size, 1)) {}
+
+void PhiAccrualDetector::reset() {
+  mIntervals.clear();
+  mSum = 0;
+  mSumSquares = 0;
+  mLastHeartbeat.reset();
+}
+
+void PhiAccrualDetector::heartbeat(double time) {
+  if (mLastHeartbeat.has_value()) {
+    if (time < mLastHeartbeat.value()) return;
+    const double interval = time - mLastHeartbeat.value();
+    mIntervals.push_back(interval);
+    mSum += interval;
+    mSumSquares += interval * interval;
+    if (mIntervals.size() > mWindowSize) {
+      mSum -= mIntervals.front();
+      mSumSquares -= mIntervals.front() * mIntervals.front();
+      mIntervals.pop_front();
+    }
+  }
+  mLastHeartbeat = time;
+}
+
+double PhiAccrualDetector::phi(double time) const {
+  if (!mLastHeartbeat.has_value()) return 0;
+  double mean = mFirstInterval;
+  double std_dev = mFirstInterval / 4;
+  if (!mIntervals.empty()) {
+    const double n = mIntervals.size();
+    mean = mSum / n;
+    std_dev = std::sqrt(std::max(0.0, mSumSquares / n - mean * mean));
+  }
+  mean += mAcceptablePause;
+  std_dev = std::max(std_dev, mMinStdDev);
+
+  // Logistic approximation of the normal tail probability, which stays accurate
+  // far into the tail (used by Akka and Cassandra)
+  const double elapsed = std::max(0.0, time - mLastHeartbeat.value());
+  const double y = (elapsed - mean) / std_dev;
+  const double e = std::exp(-y * (1.5976 + 0.070566 * y * y));
+  if (elapsed > mean) {
+    return -std::log10(e / (1.0 + e));
+  }
+  return -std::log10(1.0 - 1.0 / (1.0 + e));
+}
+
+}  // namespace dpgo_ros
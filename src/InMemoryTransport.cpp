@@ -0,0 +1,70 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/InMemoryTransport.h>
+
+namespace dpgo_ros {
+
+size_t InMemoryBus::spinOnce() {
+  // Messages published by the callbacks are delivered at the next call
+  std::deque<std::function<void()>> queue;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    queue.swap(mQueue);
+  }
+  for (const auto &deliver : queue) {
+    deliver();
+  }
+  return queue.size();
+}
+
+size_t InMemoryBus::numQueuedMessages() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mQueue.size();
+}
+
+void InMemoryBus::subscribe(unsigned robot_id, const PGOAgentMessageHandlers &handlers) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mSubscribers[robot_id].push_back(handlers);
+}
+
+InMemoryTransport::InMemoryTransport(InMemoryBus &bus, unsigned robot_id)
+    : mBus(bus), mRobotID(robot_id) {}
+
+void InMemoryTransport::publishCommand(const CommandConstPtr &msg) {
+  mBus.post(mRobotID, &PGOAgentMessageHandlers::command, msg, true);
+}
+
+void InMemoryTransport::publishStatus(const StatusConstPtr &msg) {
+  mBus.post(mRobotID, &PGOAgentMessageHandlers::status, msg, true);
+}
+
+void InMemoryTransport::publishPublicPoses(const PublicPosesConstPtr &msg) {
+  mBus.post(mRobotID, &PGOAgentMessageHandlers::public_poses, msg);
+}
+
+void InMemoryTransport::publishAnchor(const PublicPosesConstPtr &msg) {
+  mBus.post(mRobotID, &PGOAgentMessageHandlers::anchor, msg);
+}
+
+void InMemoryTransport::publishLiftingMatrix(const MatrixMsgConstPtr &msg) {
+  mBus.post(mRobotID, &PGOAgentMessageHandlers::lifting_matrix, msg);
+}
+
+void InMemoryTransport::publishPublicMeasurements(const RelativeMeasurementListConstPtr &msg) {
+  mBus.post(mRobotID, &PGOAgentMessageHandlers::public_measurements, msg);
+}
+
+void InMemoryTransport::publishMeasurementWeights(const RelativeMeasurementWeightsConstPtr &msg) {
+  mBus.post(mRobotID, &PGOAgentMessageHandlers::measurement_weights, msg);
+}
+
+void InMemoryTransport::subscribe(unsigned robot_id, const PGOAgentMessageHandlers &handlers) {
+  mBus.subscribe(robot_id, handlers);
+}
+
+}  // namespace dpgo_ros
@@ -0,0 +1,246 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/NeighborCache.h>
+
+#include <algorithm>
+
+namespace dpgo_ros {
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+  // splitmix64 finalizer
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+uint64_t hashEdge(const EdgeID &edge_id) {
+  const uint64_t src = ((uint64_t) edge_id.src_pose_id.robot_id << 32) | edge_id.src_pose_id.frame_id;
+  const uint64_t dst = ((uint64_t) edge_id.dst_pose_id.robot_id << 32) | edge_id.dst_pose_id.frame_id;
+  return mix(src ^ mix(dst));
+}
+
+}  // namespace
+
+NeighborPoseCache::NeighborPoseCache(unsigned d, size_t capacity)
+    : mD(d), mCapacity(capacity), mSize(0) {}
+
+void NeighborPoseCache::setDimension(unsigned d) {
+  if (d == mD) return;
+  mD = d;
+  clear();
+}
+
+bool NeighborPoseCache::insert(const PoseID &id, const Matrix &T, unsigned round) {
+  if (T.rows() != mD || T.cols() != mD + 1) return false;
+  const size_t block_size = mD * (mD + 1);
+  auto compare_robot = [](const RobotPoses &robot, unsigned robot_id) { return robot.robotID < robot_id; };
+
+  auto robot = std::lower_bound(mRobots.begin(), mRobots.end(), id.robot_id, compare_robot);
+  if (robot != mRobots.end() && robot->robotID == id.robot_id) {
+    robot->lastSeenRound = std::max(robot->lastSeenRound, round);
+    auto frame = std::lower_bound(robot->frameIDs.begin(), robot->frameIDs.end(), id.frame_id);
+    if (frame != robot->frameIDs.end() && *frame == id.frame_id) {
+      const size_t idx = frame - robot->frameIDs.begin();
+      std::copy(T.data(), T.data() + block_size, robot->poses.begin() + idx * block_size);
+      return true;
+    }
+  }
+
+  // New pose: make room by evicting other robots
+  while (mCapacity > 0 && mSize >= mCapacity) {
+    if (!evictLeastRecentRobot(id.robot_id)) return false;
+  }
+  robot = std::lower_bound(mRobots.begin(), mRobots.end(), id.robot_id, compare_robot);
+  if (robot == mRobots.end() || robot->robotID != id.robot_id) {
+    RobotPoses new_robot;
+    new_robot.robotID = id.robot_id;
+    new_robot.lastSeenRound = round;
+    robot = mRobots.insert(robot, std::move(new_robot));
+  }
+  // Poses usually arrive in increasing frame order, so this is typically an append
+  auto frame = std::lower_bound(robot->frameIDs.begin(), robot->frameIDs.end(), id.frame_id);
+  const size_t idx = frame - robot->frameIDs.begin();
+  robot->frameIDs.insert(frame, id.frame_id);
+  robot->poses.insert(robot->poses.begin() + idx * block_size, T.data(), T.data() + block_size);
+  mSize++;
+  return true;
+}
+
+bool NeighborPoseCache::find(const PoseID &id, Matrix &T) const {
+  auto robot = std::lower_bound(mRobots.begin(), mRobots.end(), id.robot_id,
+                                [](const RobotPoses &robot, unsigned robot_id) { return robot.robotID < robot_id; });
+  if (robot == mRobots.end() || robot->robotID != id.robot_id) return false;
+  auto frame = std::lower_bound(robot->frameIDs.begin(), robot->frameIDs.end(), id.frame_id);
+  if (frame == robot->frameIDs.end() || *frame != id.frame_id) return false;
+  const size_t block_size = mD * (mD + 1);
+  const size_t idx = frame - robot->frameIDs.begin();
+  T = Eigen::Map<const Matrix>(robot->poses.data() + idx * block_size, mD, mD + 1);
+  return true;
+}
+
+size_t NeighborPoseCache::evictIdleRobots(unsigned round, unsigned max_idle_rounds) {
+  size_t num_evicted = 0;
+  for (auto it = mRobots.begin(); it != mRobots.end();) {
+    if (it->lastSeenRound + max_idle_rounds < round) {
+      mSize -= it->frameIDs.size();
+      it = mRobots.erase(it);
+      num_evicted++;
+    } else {
+      ++it;
+    }
+  }
+  return num_evicted;
+}
+
+size_t NeighborPoseCache::memoryUsage() const {
+  size_t bytes = mRobots.capacity() * sizeof(RobotPoses);
+  for (const auto &robot : mRobots) {
+    bytes += robot.frameIDs.capacity() * sizeof(unsigned);
+    bytes += robot.poses.capacity() * sizeof(double);
+  }
+  return bytes;
+}
+
+bool NeighborPoseCache::evictLeastRecentRobot(unsigned robot_id) {
+  auto victim = mRobots.end();
+  for (auto it = mRobots.begin(); it != mRobots.end(); ++it) {
+    if (it->robotID == robot_id) continue;
+    if (victim == mRobots.end() || it->lastSeenRound < victim->lastSeenRound) victim = it;
+  }
+  if (victim == mRobots.end()) return false;
+  mSize -= victim->frameIDs.size();
+  mRobots.erase(victim);
+  return true;
+}
+
+EdgeWeightCache::EdgeWeightCache(size_t capacity)
+    : mCapacity(capacity), mSize(0) {}
+
+bool EdgeWeightCache::insert(const EdgeID &edge_id, double weight, unsigned round) {
+  const unsigned robot1 = edge_id.src_pose_id.robot_id;
+  const unsigned robot2 = edge_id.dst_pose_id.robot_id;
+  markSeen(robot1, round);
+  markSeen(robot2, round);
+  size_t idx = findSlot(edge_id);
+  if (idx < mSlots.size() && mSlots[idx].occupied) {
+    mSlots[idx].weight = weight;
+    return true;
+  }
+
+  // New edge: make room by evicting the least recently seen robots
+  while (mCapacity > 0 && mSize >= mCapacity) {
+    unsigned victim = kNeverSeen;
+    for (unsigned robot = 0; robot < mLastSeenRound.size(); ++robot) {
+      if (robot == robot1 || robot == robot2 || mLastSeenRound[robot] == kNeverSeen) continue;
+      if (victim == kNeverSeen || mLastSeenRound[robot] < mLastSeenRound[victim]) victim = robot;
+    }
+    if (victim == kNeverSeen) return false;
+    std::vector<bool> removed(mLastSeenRound.size(), false);
+    removed[victim] = true;
+    removeRobots(removed);
+  }
+  if (2 * (mSize + 1) > mSlots.size()) {
+    rehash(std::max<size_t>(16, 2 * mSlots.size()));
+  }
+  idx = findSlot(edge_id);
+  Slot &slot = mSlots[idx];
+  slot.r1 = robot1;
+  slot.p1 = edge_id.src_pose_id.frame_id;
+  slot.r2 = robot2;
+  slot.p2 = edge_id.dst_pose_id.frame_id;
+  slot.weight = weight;
+  slot.occupied = true;
+  mSize++;
+  return true;
+}
+
+bool EdgeWeightCache::find(const EdgeID &edge_id, double &weight) const {
+  const size_t idx = findSlot(edge_id);
+  if (idx >= mSlots.size() || !mSlots[idx].occupied) return false;
+  weight = mSlots[idx].weight;
+  return true;
+}
+
+size_t EdgeWeightCache::evictIdleRobots(unsigned round, unsigned max_idle_rounds) {
+  std::vector<bool> removed(mLastSeenRound.size(), false);
+  size_t num_evicted = 0;
+  for (unsigned robot = 0; robot < mLastSeenRound.size(); ++robot) {
+    if (mLastSeenRound[robot] == kNeverSeen) continue;
+    if (mLastSeenRound[robot] + max_idle_rounds < round) {
+      removed[robot] = true;
+      num_evicted++;
+    }
+  }
+  if (num_evicted > 0) removeRobots(removed);
+  return num_evicted;
+}
+
+void EdgeWeightCache::clear() {
+  mSlots.clear();
+  mLastSeenRound.clear();
+  mSize = 0;
+}
+
+size_t EdgeWeightCache::memoryUsage() const {
+  return mSlots.capacity() * sizeof(Slot) + mLastSeenRound.capacity() * sizeof(unsigned);
+}
+
+size_t EdgeWeightCache::findSlot(const EdgeID &edge_id) const {
+  if (mSlots.empty()) return 0;
+  const size_t mask = mSlots.size() - 1;
+  size_t idx = hashEdge(edge_id) & mask;
+  // Terminates since at least half of the slots are empty
+  while (mSlots[idx].occupied) {
+    const Slot &slot = mSlots[idx];
+    if (slot.r1 == edge_id.src_pose_id.robot_id && slot.p1 == edge_id.src_pose_id.frame_id &&
+        slot.r2 == edge_id.dst_pose_id.robot_id && slot.p2 == edge_id.dst_pose_id.frame_id)
+      break;
+    idx = (idx + 1) & mask;
+  }
+  return idx;
+}
+
+void EdgeWeightCache::rehash(size_t num_slots) {
+  std::vector<Slot> slots(num_slots, Slot{0, 0, 0, 0, 0.0, false});
+  mSlots.swap(slots);
+  mSize = 0;
+  for (const auto &slot : slots) {
+    if (!slot.occupied) continue;
+    const EdgeID edge_id(PoseID(slot.r1, slot.p1), PoseID(slot.r2, slot.p2));
+    mSlots[findSlot(edge_id)] = slot;
+    mSize++;
+  }
+}
+
+void EdgeWeightCache::removeRobots(const std::vector<bool> &removed) {
+  for (unsigned robot = 0; robot < removed.size(); ++robot) {
+    if (removed[robot]) mLastSeenRound[robot] = kNeverSeen;
+  }
+  // Rebuild the table instead of leaving tombstones
+  for (auto &slot : mSlots) {
+    if (!slot.occupied) continue;
+    if ((slot.r1 < removed.size() && removed[slot.r1]) || (slot.r2 < removed.size() && removed[slot.r2])) {
+      slot.occupied = false;
+    }
+  }
+  rehash(mSlots.size());
+}
+
+void EdgeWeightCache::markSeen(unsigned robot_id, unsigned round) {
+  if (robot_id >= mLastSeenRound.size()) mLastSeenRound.resize(robot_id + 1, kNeverSeen);
+  if (mLastSeenRound[robot_id] == kNeverSeen || mLastSeenRound[robot_id] < round) {
+    mLastSeenRound[robot_id] = round;
+  }
+}
+
+}  // namespace dpgo_ros
@@ -0,0 +1,342 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/Command.h>
+#include <dpgo_ros/MatrixMsg.h>
+#include <dpgo_ros/PublicPoses.h>
+#include <dpgo_ros/RelativeMeasurementList.h>
+#include <dpgo_ros/RelativeMeasurementWeights.h>
+#include <dpgo_ros/Status.h>
+#include <ros/console.h>
+#include <ros/ros.h>
+#include <std_msgs/UInt16MultiArray.h>
+#include <topic_tools/shape_shifter.h>
+
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+This node relays the messages exchanged between PGO agents and emulates an
+impaired network (latency, jitter, loss, limited bandwidth and scripted
+disconnections) on each directed link. Messages published by robot i on
+/<robot i>/dpgo_ros_node/<topic> are republished for robot j on
+<output_prefix>/<robot j>/<robot i>/dpgo_ros_node/<topic>, so agent j must be
+launched with incoming_topic_prefix set to <output_prefix>/<robot j>.
+The node also publishes /<robot j>/connected_peer_ids according to the scripted disconnections.
+*/
+
+namespace {
+
+template <typename M>
+ros::Publisher advertiseRelay(ros::NodeHandle &nh, const std::string &topic) {
+  return nh.advertise<M>(topic, 100);
+}
+
+// Topics exchanged between agents, and how to advertise their relays
+const std::map<std::string, ros::Publisher (*)(ros::NodeHandle &, const std::string &)> kAgentTopics = {
+    {"lifting_matrix", &advertiseRelay<dpgo_ros::MatrixMsg>},
+    {"status", &advertiseRelay<dpgo_ros::Status>},
+    {"command", &advertiseRelay<dpgo_ros::Command>},
+    {"anchor", &advertiseRelay<dpgo_ros::PublicPoses>},
+    {"public_poses", &advertiseRelay<dpgo_ros::PublicPoses>},
+    {"public_measurements", &advertiseRelay<dpgo_ros::RelativeMeasurementList>},
+    {"measurement_weights", &advertiseRelay<dpgo_ros::RelativeMeasurementWeights>}};
+
+struct LinkParameters {
+  // Mean one-way delay in seconds
+  double latency = 0;
+  // Standard deviation of the delay in seconds
+  double jitter = 0;
+  // Probability of dropping a message
+  double loss = 0;
+  // Capacity in bytes per second (0 for unlimited)
+  double bandwidth = 0;
+};
+
+struct LinkState {
+  LinkParameters params;
+  // Time when the link finishes transmitting queued messages
+  ros::Time busy_until;
+  // Delivery time of the latest message (messages on a link are delivered in order)
+  ros::Time last_delivery;
+  size_t num_relayed = 0;
+  size_t num_dropped = 0;
+  size_t bytes_relayed = 0;
+};
+
+struct Disconnection {
+  // Seconds since the emulator started
+  double start;
+  double end;
+  // Robots disconnected from each other. If robot_b is negative,
+  // robot_a is disconnected from all other robots.
+  int robot_a;
+  int robot_b;
+};
+
+struct PendingMessage {
+  ros::Time delivery_time;
+  uint64_t sequence;
+  ros::Publisher *publisher;
+  topic_tools::ShapeShifter::ConstPtr msg;
+
+  bool operator>(const PendingMessage &other) const {
+    if (delivery_time == other.delivery_time) return sequence > other.sequence;
+    return delivery_time > other.delivery_time;
+  }
+};
+
+// Read a member of a script entry. Return false with a readable error if it is missing or
+// has the wrong type, instead of letting XmlRpcValue throw.
+bool readInt(XmlRpc::XmlRpcValue &value, const std::string &name, const std::string &entry, int &result) {
+  if (value.getType() != XmlRpc::XmlRpcValue::TypeStruct || !value.hasMember(name) ||
+      value[name].getType() != XmlRpc::XmlRpcValue::TypeInt) {
+    ROS_ERROR("NetworkEmulator: %s needs an integer '%s'.", entry.c_str(), name.c_str());
+    return false;
+  }
+  result = static_cast<int &>(value[name]);
+  return true;
+}
+
+bool readDouble(XmlRpc::XmlRpcValue &value, const std::string &name, const std::string &entry, double &result) {
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeStruct && value.hasMember(name)) {
+    if (value[name].getType() == XmlRpc::XmlRpcValue::TypeInt) {
+      result = (double) static_cast<int &>(value[name]);
+      return true;
+    }
+    if (value[name].getType() == XmlRpc::XmlRpcValue::TypeDouble) {
+      result = static_cast<double &>(value[name]);
+      return true;
+    }
+  }
+  ROS_ERROR("NetworkEmulator: %s needs a number '%s'.", entry.c_str(), name.c_str());
+  return false;
+}
+
+bool readLinkParameters(XmlRpc::XmlRpcValue &value, const std::string &entry, LinkParameters &params) {
+  if (value.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+    ROS_ERROR("NetworkEmulator: %s is not a dictionary.", entry.c_str());
+    return false;
+  }
+  bool success = true;
+  if (value.hasMember("latency")) success &= readDouble(value, "latency", entry, params.latency);
+  if (value.hasMember("jitter")) success &= readDouble(value, "jitter", entry, params.jitter);
+  if (value.hasMember("loss")) success &= readDouble(value, "loss", entry, params.loss);
+  if (value.hasMember("bandwidth")) success &= readDouble(value, "bandwidth", entry, params.bandwidth);
+  return success;
+}
+
+}  // namespace
+
+class NetworkEmulator {
+ public:
+  NetworkEmulator(const ros::NodeHandle &nh_, const ros::NodeHandle &nh_private_)
+      : nh(nh_), nh_private(nh_private_), num_robots(0), output_prefix("/network_emulator") {
+    if (!nh_private.getParam("num_robots", num_robots) || num_robots <= 0) {
+      ROS_ERROR("NetworkEmulator: failed to get number of robots!");
+      return;
+    }
+    for (int id = 0; id < num_robots; ++id) {
+      std::string robot_name = "kimera" + std::to_string(id);
+      nh_private.getParam("robot" + std::to_string(id) + "_name", robot_name);
+      robotNames.push_back(robot_name);
+    }
+    nh_private.getParam("output_prefix", output_prefix);
+    int seed = 0;
+    nh_private.getParam("seed", seed);
+    rng.seed(seed);
+
+    // Link parameters
+    LinkParameters default_params;
+    XmlRpc::XmlRpcValue value;
+    if (nh_private.getParam("default_link", value)) readLinkParameters(value, "default_link", default_params);
+    links.assign(num_robots, std::vector<LinkState>(num_robots));
+    for (int src = 0; src < num_robots; ++src) {
+      for (int dst = 0; dst < num_robots; ++dst) {
+        // Messages to self are delivered without impairment
+        if (src != dst) links[src][dst].params = default_params;
+      }
+    }
+    if (nh_private.getParam("links", value) && value.getType() == XmlRpc::XmlRpcValue::TypeArray) {
+      for (int i = 0; i < value.size(); ++i) {
+        const std::string entry = "links[" + std::to_string(i) + "]";
+        int src = -1, dst = -1;
+        if (!readInt(value[i], "from", entry, src) || !readInt(value[i], "to", entry, dst)) continue;
+        if (src < 0 || dst < 0 || src >= num_robots || dst >= num_robots || src == dst) {
+          ROS_ERROR("NetworkEmulator: invalid link %i -> %i.", src, dst);
+          continue;
+        }
+        readLinkParameters(value[i], entry, links[src][dst].params);
+      }
+    }
+
+    // Scripted disconnections
+    if (nh_private.getParam("disconnections", value) && value.getType() == XmlRpc::XmlRpcValue::TypeArray) {
+      for (int i = 0; i < value.size(); ++i) {
+        const std::string entry = "disconnections[" + std::to_string(i) + "]";
+        Disconnection disconnection;
+        disconnection.robot_b = -1;
+        if (!readDouble(value[i], "start", entry, disconnection.start) ||
+            !readDouble(value[i], "end", entry, disconnection.end) ||
+            !readInt(value[i], "robot", entry, disconnection.robot_a))
+          continue;
+        if (value[i].hasMember("peer") && !readInt(value[i], "peer", entry, disconnection.robot_b)) continue;
+        disconnections.push_back(disconnection);
+      }
+    }
+
+    // Relay publishers are advertised up front, so that agents are connected before the
+    // first message of a topic is relayed (e.g., one-shot shared loop closures)
+    relayPublishers.assign(num_robots, std::vector<std::map<std::string, ros::Publisher>>(num_robots));
+    for (int src = 0; src < num_robots; ++src) {
+      for (int dst = 0; dst < num_robots; ++dst) {
+        for (const auto &it : kAgentTopics) {
+          const std::string relay_topic = output_prefix + "/" + robotNames[dst] + "/" +
+                                          robotNames[src] + "/dpgo_ros_node/" + it.first;
+          relayPublishers[src][dst][it.first] = it.second(nh, relay_topic);
+        }
+      }
+    }
+    for (int src = 0; src < num_robots; ++src) {
+      for (const auto &it : kAgentTopics) {
+        const std::string &topic = it.first;
+        const std::string topic_name = "/" + robotNames[src] + "/dpgo_ros_node/" + topic;
+        boost::function<void(const topic_tools::ShapeShifter::ConstPtr &)> callback =
+            [this, src, topic](const topic_tools::ShapeShifter::ConstPtr &msg) {
+              messageCallback(src, topic, msg);
+            };
+        subscribers.push_back(nh.subscribe<topic_tools::ShapeShifter>(topic_name, 100, callback));
+      }
+      connectivityPublishers.push_back(
+          nh.advertise<std_msgs::UInt16MultiArray>("/" + robotNames[src] + "/connected_peer_ids", 5));
+    }
+
+    double tick_rate = 1000;
+    double connectivity_rate = 1;
+    nh_private.getParam("tick_rate", tick_rate);
+    nh_private.getParam("connectivity_rate", connectivity_rate);
+    startTime = ros::Time::now();
+    deliveryTimer = nh.createTimer(ros::Duration(1.0 / tick_rate), &NetworkEmulator::deliveryTimerCallback, this);
+    connectivityTimer = nh.createTimer(ros::Duration(1.0 / connectivity_rate),
+                                       &NetworkEmulator::connectivityTimerCallback, this);
+    ROS_INFO("NetworkEmulator: relaying messages of %i robots with %zu scripted disconnections.",
+             num_robots, disconnections.size());
+  }
+
+  ~NetworkEmulator() {
+    for (int src = 0; src < num_robots; ++src) {
+      for (int dst = 0; dst < num_robots; ++dst) {
+        const auto &link = links[src][dst];
+        if (src == dst || link.num_relayed + link.num_dropped == 0) continue;
+        ROS_INFO("NetworkEmulator: link %i -> %i relayed %zu messages (%zu bytes), dropped %zu.",
+                 src, dst, link.num_relayed, link.bytes_relayed, link.num_dropped);
+      }
+    }
+  }
+
+ private:
+  ros::NodeHandle nh;
+  ros::NodeHandle nh_private;
+  int num_robots;
+  std::string output_prefix;
+  std::vector<std::string> robotNames;
+  std::mt19937 rng;
+
+  // Directed links indexed by [source robot][destination robot]
+  std::vector<std::vector<LinkState>> links;
+  std::vector<Disconnection> disconnections;
+  ros::Time startTime;
+
+  // Messages waiting to be delivered, ordered by delivery time
+  std::priority_queue<PendingMessage, std::vector<PendingMessage>, std::greater<PendingMessage>> pendingMessages;
+  uint64_t numMessagesReceived = 0;
+
+  std::vector<ros::Subscriber> subscribers;
+  // Relay publishers indexed by [source robot][destination robot][topic]
+  std::vector<std::vector<std::map<std::string, ros::Publisher>>> relayPublishers;
+  std::vector<ros::Publisher> connectivityPublishers;
+  ros::Timer deliveryTimer;
+  ros::Timer connectivityTimer;
+
+  bool isConnected(int robot_a, int robot_b, const ros::Time &time) const {
+    if (robot_a == robot_b) return true;
+    const double t = (time - startTime).toSec();
+    for (const auto &d : disconnections) {
+      if (t < d.start || t >= d.end) continue;
+      if (d.robot_b < 0 && (d.robot_a == robot_a || d.robot_a == robot_b)) return false;
+      if ((d.robot_a == robot_a && d.robot_b == robot_b) ||
+          (d.robot_a == robot_b && d.robot_b == robot_a))
+        return false;
+    }
+    return true;
+  }
+
+  void messageCallback(int src, const std::string &topic, const topic_tools::ShapeShifter::ConstPtr &msg) {
+    const ros::Time now = ros::Time::now();
+    for (int dst = 0; dst < num_robots; ++dst) {
+      auto &link = links[src][dst];
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+      if (!isConnected(src, dst, now) || uniform(rng) < link.params.loss) {
+        link.num_dropped++;
+        continue;
+      }
+
+      // Transmission is serialized on the link when bandwidth is limited
+      ros::Time sent_time = now;
+      if (link.params.bandwidth > 0) {
+        const ros::Time start = std::max(now, link.busy_until);
+        link.busy_until = start + ros::Duration(msg->size() / link.params.bandwidth);
+        sent_time = link.busy_until;
+      }
+      double delay = link.params.latency;
+      if (link.params.jitter > 0) {
+        std::normal_distribution<double> normal(0.0, link.params.jitter);
+        delay = std::max(0.0, delay + normal(rng));
+      }
+      const ros::Time delivery_time = std::max(sent_time + ros::Duration(delay), link.last_delivery);
+      link.last_delivery = delivery_time;
+      link.num_relayed++;
+      link.bytes_relayed += msg->size();
+
+      pendingMessages.push({delivery_time, numMessagesReceived++, &relayPublishers[src][dst].at(topic), msg});
+    }
+  }
+
+  void deliveryTimerCallback(const ros::TimerEvent &event) {
+    const ros::Time now = ros::Time::now();
+    while (!pendingMessages.empty() && pendingMessages.top().delivery_time <= now) {
+      const auto &pending = pendingMessages.top();
+      pending.publisher->publish(pending.msg);
+      pendingMessages.pop();
+    }
+  }
+
+  void connectivityTimerCallback(const ros::TimerEvent &event) {
+    const ros::Time now = ros::Time::now();
+    for (int robot_id = 0; robot_id < num_robots; ++robot_id) {
+      std_msgs::UInt16MultiArray msg;
+      for (int peer_id = 0; peer_id < num_robots; ++peer_id) {
+        if (peer_id != robot_id && isConnected(robot_id, peer_id, now)) msg.data.push_back(peer_id);
+      }
+      connectivityPublishers[robot_id].publish(msg);
+    }
+  }
+};
+
+int main(int argc, char **argv) {
+  ros::init(argc, argv, "network_emulator_node");
+  ros::NodeHandle nh;
+  ros::NodeHandle nh_private("~");
+  NetworkEmulator network_emulator(nh, nh_private);
+  ros::spin();
+
+  return 0;
+}
@@ -6,6 +6,7 @@
  * -------------------------------------------------------------------------- */
 
 #include <dpgo_ros/PGOAgentROS.h>
+#include <dpgo_ros/ROSTransport.h>
 #include <dpgo_ros/utils.h>
 #include <DPGO/DPGO_solver.h>
 #include <geometry_msgs/PoseArray.h>
@@ -14,92 +15,188 @@
 #include <pose_graph_tools/PoseGraphQuery.h>
 #include <pose_graph_tools/utils.h>
 #include <glog/logging.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
 #include <map>
 #include <random>
+#include <set>
+#include <unordered_map>
 
 using namespace DPGO;
 
 namespace dpgo_ros {
 
-PGOAgentROS::PGOAgentROS(const ros::NodeHandle &nh_, unsigned ID,
-                         const PGOAgentROSParameters &params)
+PGOAgentROS::PGOAgentROS(const ros::NodeHandle &nh_, const ros::NodeHandle &nh_private_,
+                         unsigned ID, const PGOAgentROSParameters &params,
+                         std::unique_ptr<PGOAgentTransport> transport)
     : PGOAgent(ID, params),
       nh(nh_),
+      nh_private(nh_private_),
       mParamsROS(params),
       mClusterID(ID),
       mInitStepsDone(0),
       mTotalBytesReceived(0),
-      mIterationElapsedMs(0) {
+      mIterationElapsedMs(0),
+      mConvergencePredictor(mParamsROS.predictionWindow),
+      mCachedNeighborPoses(params.d, std::max(0, params.neighborCacheCapacity)),
+      mCachedEdgeWeights(std::max(0, params.neighborCacheCapacity)) {
   mTeamIterRequired.assign(mParams.numRobots, 0);
   mTeamIterReceived.assign(mParams.numRobots, 0);
   mTeamReceivedSharedLoopClosures.assign(mParams.numRobots, false);
   mTeamConnected.assign(mParams.numRobots, true);
+  // Gaps up to the heartbeat period are expected between bursts of messages during optimization
+  mFailureDetectors.assign(mParams.numRobots,
+                           PhiAccrualDetector(mParamsROS.heartbeatPeriod, mParamsROS.heartbeatPeriod));
+  mPublicPosesMailbox.assign(mParams.numRobots, PublicPosesMailboxSlot());
+  mAuxPublicPosesMailbox.assign(mParams.numRobots, PublicPosesMailboxSlot());
 
   // Load robot names
   for (size_t id = 0; id < mParams.numRobots; id++) {
     std::string robot_name = "kimera" + std::to_string(id);
-    ros::param::get("~robot" + std::to_string(id) + "_name", robot_name);
+    nh_private.getParam("robot" + std::to_string(id) + "_name", robot_name);
     mRobotNames[id] = robot_name;
   }
 
-  // ROS subscriber
-  for (size_t robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
-    std::string topic_prefix = "/" + mRobotNames.at(robot_id) + "/dpgo_ros_node/";
-    mLiftingMatrixSubscriber.push_back(
-        nh.subscribe(topic_prefix + "lifting_matrix", 100, &PGOAgentROS::liftingMatrixCallback, this));
-    mStatusSubscriber.push_back(
-        nh.subscribe(topic_prefix + "status", 100, &PGOAgentROS::statusCallback, this));
-    mCommandSubscriber.push_back(
-        nh.subscribe(topic_prefix + "command", 100, &PGOAgentROS::commandCallback, this));
-    mAnchorSubscriber.push_back(
-        nh.subscribe(topic_prefix + "anchor", 100, &PGOAgentROS::anchorCallback, this));
-    mPublicPosesSubscriber.push_back(
-        nh.subscribe(topic_prefix + "public_poses", 100, &PGOAgentROS::publicPosesCallback, this));
-    mSharedLoopClosureSubscriber.push_back(
-        nh.subscribe(topic_prefix + "public_measurements", 100, &PGOAgentROS::publicMeasurementsCallback, this));
-  }
-  mConnectivitySubscriber =
-      nh.subscribe("/" + mRobotNames.at(mID) + "/connected_peer_ids", 5,
-                   &PGOAgentROS::connectivityCallback, this);
-
-  for (size_t robot_id = 0; robot_id < getID(); ++robot_id) {
-    std::string topic_prefix = "/" + mRobotNames.at(robot_id) + "/dpgo_ros_node/";
-    mMeasurementWeightsSubscriber.push_back(
-        nh.subscribe(topic_prefix + "measurement_weights", 100, &PGOAgentROS::measurementWeightsCallback, this));
+  // Messages from other agents
+  mTransport = std::move(transport);
+  if (!mTransport) {
+    mTransport = std::make_unique<ROSTransport>(nh, mRobotNames, mParamsROS.incomingTopicPrefix);
   }
+  // Receivers restart their sequence windows when the epoch changes, e.g., after this agent restarts
+  std::random_device rd;
+  const uint32_t command_epoch = std::uniform_int_distribution<uint32_t>(1, std::numeric_limits<uint32_t>::max())(rd);
+  mCommandChannel = std::make_unique<CommandChannel>(getID(), mParams.numRobots, command_epoch, *mTransport);
 
   // ROS publisher
-  mLiftingMatrixPublisher = nh.advertise<MatrixMsg>("lifting_matrix", 1);
-  mAnchorPublisher = nh.advertise<PublicPoses>("anchor", 1);
-  mStatusPublisher = nh.advertise<Status>("status", 1);
-  mCommandPublisher = nh.advertise<Command>("command", 20);
-  mPublicPosesPublisher = nh.advertise<PublicPoses>("public_poses", 20);
-  mPublicMeasurementsPublisher = nh.advertise<RelativeMeasurementList>("public_measurements", 20);
-  mMeasurementWeightsPublisher = nh.advertise<RelativeMeasurementWeights>("measurement_weights", 20);
   mPoseArrayPublisher = nh.advertise<geometry_msgs::PoseArray>("trajectory", 1);
   mPathPublisher = nh.advertise<nav_msgs::Path>("path", 1);
   mPoseGraphPublisher = nh.advertise<pose_graph_tools::PoseGraph>("optimized_pose_graph", 1);
   mLoopClosureMarkerPublisher = nh.advertise<visualization_msgs::Marker>("loop_closures", 1);
 
-  // ROS timer
-  timer = nh.createTimer(ros::Duration(3.0), &PGOAgentROS::timerCallback, this);
-  mVisualizationTimer = nh.createTimer(ros::Duration(30.0), &PGOAgentROS::visualizationTimerCallback, this);
+  // Riemannian staircase: start at the lowest rank at which rank deficiency can be detected
+  if (mParamsROS.adaptiveRelaxationRank) {
+    if (mParams.asynchronous) {
+      ROS_WARN("Adaptive relaxation rank is not supported in asynchronous mode.");
+    } else {
+      setRelaxationRank(std::min(d + 1, mParams.r));
+    }
+  }
 
   // Initially, assume each robot is in a separate cluster
   resetRobotClusterIDs();
 
-  // Publish lifting matrix
-  for (size_t iter_ = 0; iter_ < 10; ++iter_) {
-    publishNoopCommand();
-    ros::Duration(0.5).sleep();
+  // Announce this robot with NOOP commands for 5 sec before handling messages and timers.
+  // A timer is used instead of sleeping, so that a nodelet manager thread is not blocked.
+  mStartupTimer = nh.createTimer(ros::Duration(0.5), &PGOAgentROS::startupTimerCallback, this);
+}
+
+PGOAgentROS::~PGOAgentROS() {
+  // Stop the heartbeat thread before the members used by its callbacks are destroyed
+  if (mHeartbeatSpinner) mHeartbeatSpinner->stop();
+  mHeartbeatTimer.stop();
+}
+
+void PGOAgentROS::startupTimerCallback(const ros::TimerEvent &event) {
+  publishNoopCommand();
+  if (++mNumStartupNoops < 10) {
+    return;
+  }
+  mStartupTimer.stop();
+  start();
+}
+
+void PGOAgentROS::start() {
+  // Messages from other agents
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    PGOAgentMessageHandlers handlers;
+    handlers.lifting_matrix = [this](const MatrixMsgConstPtr &msg) { liftingMatrixCallback(msg); };
+    handlers.status = [this](const StatusConstPtr &msg) { statusCallback(msg); };
+    handlers.command = [this](const CommandConstPtr &msg) { commandCallback(msg); };
+    handlers.arrival = [this, robot_id](const ros::Time &time) { receivedHeartbeat(robot_id, time); };
+    handlers.anchor = [this](const PublicPosesConstPtr &msg) { anchorCallback(msg); };
+    handlers.public_poses = [this](const PublicPosesConstPtr &msg) { publicPosesCallback(msg); };
+    handlers.public_measurements = [this](const RelativeMeasurementListConstPtr &msg) {
+      publicMeasurementsCallback(msg);
+    };
+    // Weights of shared loop closures are set by the robot with smaller ID
+    if (robot_id < getID()) {
+      handlers.measurement_weights = [this](const RelativeMeasurementWeightsConstPtr &msg) {
+        measurementWeightsCallback(msg);
+      };
+    }
+    mTransport->subscribe(robot_id, handlers);
   }
+
+  // ROS subscriber
+  mConnectivitySubscriber =
+      nh.subscribe("/" + mRobotNames.at(mID) + "/connected_peer_ids", 5,
+                   &PGOAgentROS::connectivityCallback, this);
+
+  // ROS timer
+  timer = nh.createTimer(ros::Duration(3.0), &PGOAgentROS::timerCallback, this);
+  mVisualizationTimer = nh.createTimer(ros::Duration(30.0), &PGOAgentROS::visualizationTimerCallback, this);
+  if (mParamsROS.adaptiveFailureDetection) {
+    ros::TimerOptions heartbeat_options(ros::Duration(mParamsROS.heartbeatPeriod),
+                                        [this](const ros::TimerEvent &event) { heartbeatTimerCallback(event); },
+                                        &mHeartbeatQueue);
+    mHeartbeatTimer = nh.createTimer(heartbeat_options);
+    mHeartbeatSpinner = std::make_unique<ros::AsyncSpinner>(1, &mHeartbeatQueue);
+    mHeartbeatSpinner->start();
+  }
+  if (mParamsROS.onlinePoseGraphUpdate) {
+    if (mParams.asynchronous) {
+      ROS_WARN("Online pose graph update is not supported in asynchronous mode.");
+    } else if (mParamsROS.reduceOdometryChains) {
+      ROS_WARN("Online pose graph update is not supported with odometry chain reduction.");
+    } else {
+      mOnlineUpdateTimer = nh.createTimer(ros::Duration(mParamsROS.onlineUpdatePeriod),
+                                          &PGOAgentROS::onlineUpdateTimerCallback, this);
+    }
+  }
+  if (mParamsROS.changeTriggeredRounds) {
+    mPoseGraphSummaryTimer = nh.createTimer(ros::Duration(mParamsROS.poseGraphSummaryPeriod),
+                                            &PGOAgentROS::poseGraphSummaryTimerCallback, this);
+  }
+
   mLastResetTime = ros::Time::now();
   mLaunchTime = ros::Time::now();
   mLastCommandTime = ros::Time::now();
+  mLastTimeoutCheckTime = ros::Time::now();
   mLastUpdateTime.reset();
+
+  // Warm restart from the last checkpoint
+  if (!mParamsROS.checkpointPath.empty()) {
+    loadCheckpoint();
+  }
+  mStarted = true;
 }
 
 void PGOAgentROS::runOnce() {
+  if (!mStarted) {
+    return;
+  }
+  pollPoseGraphQueries();
+  retransmitCommands();
+  if (mCommandAckRequested) publishStatus();
+
+  // The worker thread owns the iterate and the data matrices during the local solve
+  if (mLocalSolve.valid()) {
+    runOnceSynchronous();
+    return;
+  }
+  runDeferredCallbacks();
+
+  // Neighbor poses are needed right away for initialization and by the asynchronous
+  // optimization thread. Otherwise they are applied right before they are used.
+  if (mParams.asynchronous || mState != PGOAgentState::INITIALIZED) {
+    processPublicPosesMailbox();
+  }
+  refreshDataMatrices();
+
   if (mParams.asynchronous) {
     runOnceAsynchronous();
   } else {
@@ -129,6 +226,20 @@ void PGOAgentROS::runOnceAsynchronous() {
 void PGOAgentROS::runOnceSynchronous() {
   CHECK(!mParams.asynchronous);
 
+  // Wait for the local solve on the worker thread, or pass the turn when it exceeds its time budget
+  if (mLocalSolve.valid()) {
+    if (mLocalSolve.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      finishLocalSolve();
+    } else if (!mLocalSolveTurnPassed && ros::Time::now() > mLocalSolveDeadline) {
+      ROS_WARN("Robot %u local solve exceeded time budget of %.1f ms. Pass turn with previous iterate.",
+               getID(), mLocalSolveTimeBudgetMs);
+      mLocalSolveTurnPassed = true;
+      mNumLocalSolveOverruns++;
+      publishNextCommand();
+    }
+    return;
+  }
+
   // Perform an optimization step
   if (mSynchronousOptimizationRequested) {
 
@@ -156,71 +267,185 @@ void PGOAgentROS::runOnceSynchronous() {
       // mPoseGraph->useInactiveNeighbors(true);
       
       // Iterate
-      auto startTime = std::chrono::high_resolution_clock::now();
-      bool success = iterate(true);
-      auto counter = std::chrono::high_resolution_clock::now() - startTime;
-      mIterationElapsedMs = (double) std::chrono::duration_cast<std::chrono::milliseconds>(counter).count();
+      processPublicPosesMailbox();
       mSynchronousOptimizationRequested = false;
-      if (success) {
-        mLastUpdateTime.emplace(ros::Time::now());
-        ROS_INFO("Robot %u iteration %u: success=%d, func_decr=%.1e, grad_init=%.1e, grad_opt=%.1e.", 
-               getID(), 
-               iteration_number(),
-               mLocalOptResult.success,
-               mLocalOptResult.fInit - mLocalOptResult.fOpt,
-               mLocalOptResult.gradNormInit, 
-               mLocalOptResult.gradNormOpt);
-      } else {
-        ROS_WARN("Robot %u iteration not successful!", getID());
+      mLocalSolveStartTime = std::chrono::high_resolution_clock::now();
+      if (mLocalSolveTimeBudgetMs > 0) {
+        // Run the local solve on a worker thread so that the turn can be passed at the deadline
+        mLocalSolveIteration = iteration_number() + 1;
+        mLocalSolveDeadline = ros::Time::now() + ros::Duration(mLocalSolveTimeBudgetMs / 1e3);
+        mLocalSolveTurnPassed = false;
+        mLocalSolve = std::async(std::launch::async, [this]() { return iterate(true); });
+        return;
       }
+      bool success = iterate(true);
+      finishSynchronousIteration(success, true);
+    }
+  }
+}
 
-      // First robot publish anchor
-      if (isLeader()) {
-        publishAnchor();
-      }
+void PGOAgentROS::finishSynchronousIteration(bool success, bool schedule_next) {
+  auto counter = std::chrono::high_resolution_clock::now() - mLocalSolveStartTime;
+  mIterationElapsedMs = (double) std::chrono::duration_cast<std::chrono::milliseconds>(counter).count();
+  if (success) {
+    mLastUpdateTime.emplace(ros::Time::now());
+    mLastOptimizedIteration = iteration_number();
+    if (tracksLeaderState() && mParamsROS.predictiveTermination) {
+      mConvergencePredictor.addCostDecrease(mLastOptimizedIteration,
+                                            mLocalOptResult.fInit - mLocalOptResult.fOpt);
+    }
+    ROS_INFO("Robot %u iteration %u: success=%d, func_decr=%.1e, grad_init=%.1e, grad_opt=%.1e.", 
+           getID(), 
+           iteration_number(),
+           mLocalOptResult.success,
+           mLocalOptResult.fInit - mLocalOptResult.fOpt,
+           mLocalOptResult.gradNormInit, 
+           mLocalOptResult.gradNormOpt);
+  } else {
+    ROS_WARN("Robot %u iteration not successful!", getID());
+  }
 
-      // Publish status
-      publishStatus();
+  // First robot publish anchor
+  if (isLeader()) {
+    publishAnchor();
+  }
 
-      // Publish iterate (for visualization)
-      publishIterate();
-
-      // Log local iteration
-      logIteration();
-
-      // Print information
-      if (isLeader() && mParams.verbose) {
-        ROS_INFO("Num weight updates done: %i, num inner iters: %i.", mWeightUpdateCount, mRobustOptInnerIter);
-        for (size_t robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
-          if (!isRobotActive(robot_id)) continue;
-          const auto &it = mTeamStatus.find(robot_id);
-          if (it != mTeamStatus.end()) {
-            const auto &robot_status = it->second;
-            ROS_INFO("Robot %zu relative change %f.", robot_id, robot_status.relativeChange);
-          } else {
-            ROS_INFO("Robot %zu status unavailable.", robot_id);
-          }
-        }
-      }
+  // Publish status
+  publishStatus();
 
-      // Check termination condition OR notify next robot to update
-      if (isLeader()) {
-        if (shouldTerminate()) {
-          publishTerminateCommand();
-        } else if (shouldUpdateMeasurementWeights()) {
-          publishUpdateWeightCommand();
-        } else {
-          publishUpdateCommand();
-        }
+  // Publish iterate (for visualization)
+  publishIterate();
+
+  // Log local iteration
+  logIteration();
+
+  // Print information
+  if (isLeader() && mParams.verbose) {
+    ROS_INFO("Num weight updates done: %i, num inner iters: %i.", mWeightUpdateCount, mRobustOptInnerIter);
+    for (size_t robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+      if (!isRobotActive(robot_id)) continue;
+      const auto &it = mTeamStatus.find(robot_id);
+      if (it != mTeamStatus.end()) {
+        const auto &robot_status = it->second;
+        ROS_INFO("Robot %zu relative change %f.", robot_id, robot_status.relativeChange);
       } else {
-        publishUpdateCommand();
+        ROS_INFO("Robot %zu status unavailable.", robot_id);
       }
     }
   }
+
+  // The turn was already passed if the local solve exceeded its time budget
+  if (!schedule_next) return;
+  publishNextCommand();
+}
+
+void PGOAgentROS::publishNextCommand() {
+  if (!isLeader()) {
+    publishUpdateCommand();
+    return;
+  }
+  // Check termination condition OR notify next robot to update
+  const unsigned current_iteration = mLocalSolve.valid() ? mLocalSolveIteration : iteration_number();
+  auto checkRankIncrease = [this]() {
+    // The iterate belongs to the worker thread during the local solve, so the rank
+    // is checked once the leader handles its TERMINATE command
+    if (mLocalSolve.valid()) {
+      mRankIncreaseCheckPending = true;
+    } else {
+      mRankIncreasePending = relaxationRankIncreaseRequired();
+    }
+  };
+  const bool converged = mParamsROS.predictiveTermination && predictedConvergence();
+  if (shouldTerminate()) {
+    if (current_iteration < mParams.maxNumIters) checkRankIncrease();
+    publishTerminateCommand();
+  } else if (converged &&
+             (mParams.robustCostParams.costType == RobustCostParameters::Type::L2 || teamWeightsSettled())) {
+    ROS_INFO("Robot %u terminates at iteration %u by predicted convergence.", getID(), current_iteration);
+    checkRankIncrease();
+    publishTerminateCommand();
+  } else if (shouldUpdateMeasurementWeights() || converged) {
+    publishUpdateWeightCommand();
+  } else {
+    publishUpdateCommand();
+  }
+}
+
+void PGOAgentROS::finishLocalSolve() {
+  const bool success = mLocalSolve.get();
+  const bool turn_passed = mLocalSolveTurnPassed;
+  mLocalSolveTurnPassed = false;
+  finishSynchronousIteration(success, !turn_passed);
+  // Catch up with the iterations of other robots received during the local solve
+  if (mDeferredPassiveIterations > 0) {
+    processPublicPosesMailbox();
+    for (; mDeferredPassiveIterations > 0; --mDeferredPassiveIterations) {
+      iterate(false);
+    }
+    publishStatus();
+  }
+}
+
+bool PGOAgentROS::deferCallback(std::function<void()> callback, bool during_local_solve) {
+  // Keep the order of deferred messages, e.g., for the versions of weight updates
+  const bool busy = roundPoseGraphQueryPending() ||
+                    (during_local_solve && (mLocalSolve.valid() || !mDeferredCallbacks.empty()));
+  if (!busy) return false;
+  mDeferredCallbacks.push_back(std::move(callback));
+  return true;
+}
+
+void PGOAgentROS::runDeferredCallbacks() {
+  if (roundPoseGraphQueryPending()) return;
+  std::vector<std::function<void()>> callbacks;
+  callbacks.swap(mDeferredCallbacks);
+  for (const auto &callback : callbacks) callback();
+}
+
+void PGOAgentROS::waitForLocalSolve() {
+  if (!mLocalSolve.valid()) return;
+  mLocalSolve.wait();
+  finishLocalSolve();
+}
+
+double PGOAgentROS::localSolveTimeBudget() const {
+  const double max_budget_ms = 1e3 * mParamsROS.localSolveTimeBudget;
+  if (max_budget_ms <= 0) return 0;
+  std::vector<double> elapsed_ms;
+  if (mIterationElapsedMs > 0) elapsed_ms.push_back(mIterationElapsedMs);
+  for (const auto &it : mTeamStatusMsg) {
+    const auto &status = it.second;
+    if (it.first == getID() || status.cluster_id != getClusterID() || !isRobotActive(it.first)) continue;
+    if (status.iteration_elapsed_ms > 0) elapsed_ms.push_back(status.iteration_elapsed_ms);
+  }
+  if (elapsed_ms.empty()) return max_budget_ms;
+  auto median = elapsed_ms.begin() + elapsed_ms.size() / 2;
+  std::nth_element(elapsed_ms.begin(), median, elapsed_ms.end());
+  return std::min(max_budget_ms, mParamsROS.timeBudgetMedianFactor * (*median));
 }
 
 void PGOAgentROS::reset() {
+  if (mLocalSolve.valid()) mLocalSolve.get();
+  mLocalSolveTurnPassed = false;
+  mRankIncreaseCheckPending = false;
+  mDeferredPassiveIterations = 0;
+  if (mNumLocalSolveOverruns > 0) {
+    ROS_INFO("Robot %u local solve exceeded its time budget %zu times.", getID(), mNumLocalSolveOverruns);
+  }
+  mNumLocalSolveOverruns = 0;
+  // The base class resets the pose graph, which discards its data matrices and
+  // preconditioner. Reset a placeholder instead and keep the current pose graph.
+  std::shared_ptr<PoseGraph> reused_pose_graph;
+  if (reuseDataMatrices()) {
+    reused_pose_graph = mPoseGraph;
+    mPoseGraph = std::make_shared<PoseGraph>(mID, r, d);
+  }
   PGOAgent::reset();
+  if (reused_pose_graph) {
+    mPoseGraph = reused_pose_graph;
+    mPoseGraph->clearNeighborPoses();
+    mPoseGraph->clearLinearMatrix();
+  }
   mSynchronousOptimizationRequested = false;
   mTryInitializeRequested = false;
   mInitStepsDone = 0;
@@ -229,6 +454,26 @@ void PGOAgentROS::reset() {
   mTeamReceivedSharedLoopClosures.assign(mParams.numRobots, false);
   mTotalBytesReceived = 0;
   mTeamStatusMsg.clear();
+  if (mNumStalePublicPoses > 0) {
+    ROS_INFO("Robot %u dropped %zu stale public poses messages.", getID(), mNumStalePublicPoses);
+  }
+  mPublicPosesMailbox.assign(mParams.numRobots, PublicPosesMailboxSlot());
+  mAuxPublicPosesMailbox.assign(mParams.numRobots, PublicPosesMailboxSlot());
+  mNumStalePublicPoses = 0;
+  invalidatePublicPosesSendPlans();
+  mSentEdgeWeightTables.clear();
+  mSentEdgeWeightTablesValid = false;
+  mReceivedEdgeWeightTables.clear();
+  mDataMatricesStale = false;
+  mWeightConvergenceCounts.clear();
+  mPendingSharedLoopClosures.clear();
+  mDeferredCallbacks.clear();
+  for (auto &query : mPoseGraphQueries) query.abandoned = true;
+  mStatusSnapshot.reset();
+  mLastOptimizedIteration = 0;
+  mLastWeightChange = 1;
+  mConvergencePredictor.reset();
+  mPredictorStartIteration = 0;
   if (mIterationLog.is_open()) {
     mIterationLog.close();
   }
@@ -239,45 +484,172 @@ void PGOAgentROS::reset() {
     mCachedLoopClosureMarkers.reset();
   }
   resetRobotClusterIDs();
+  mFailedLeaderID.reset();
   mLastResetTime = ros::Time::now();
   mLastUpdateTime.reset();
 }
 
-bool PGOAgentROS::requestPoseGraph() {
-  // Query local pose graph
-  pose_graph_tools::PoseGraphQuery query;
-  query.request.robot_id = getID();
-  std::string service_name = "/" + mRobotNames.at(getID()) +
+bool PGOAgentROS::startPoseGraphQuery(PoseGraphQuery::Purpose purpose) {
+  // A query that timed out cannot be cancelled. Wait until it returns before starting another.
+  for (const auto &query : mPoseGraphQueries) {
+    if (query.purpose == purpose) return false;
+  }
+  const std::string service_name = "/" + mRobotNames.at(getID()) +
       "/distributed_loop_closure/request_pose_graph";
-  if (!ros::service::waitForService(service_name, ros::Duration(5.0))) {
-    ROS_ERROR_STREAM("ROS service " << service_name << " does not exist!");
-    return false;
+  const unsigned robot_id = getID();
+  PoseGraphQuery query;
+  query.purpose = purpose;
+  query.start_time = ros::Time::now();
+  query.result = std::async(std::launch::async, [service_name, robot_id]() {
+    std::optional<pose_graph_tools::PoseGraph> pose_graph;
+    if (!ros::service::waitForService(service_name, ros::Duration(5.0))) {
+      ROS_ERROR_STREAM("ROS service " << service_name << " does not exist!");
+      return pose_graph;
+    }
+    pose_graph_tools::PoseGraphQuery srv;
+    srv.request.robot_id = robot_id;
+    if (!ros::service::call(service_name, srv)) {
+      ROS_ERROR_STREAM("Failed to call ROS service " << service_name);
+      return pose_graph;
+    }
+    pose_graph.emplace(std::move(srv.response.pose_graph));
+    return pose_graph;
+  });
+  mPoseGraphQueries.push_back(std::move(query));
+  return true;
+}
+
+void PGOAgentROS::pollPoseGraphQueries() {
+  // Handle results after the loop, as handlers may start new queries
+  std::vector<std::pair<PoseGraphQuery::Purpose, std::optional<pose_graph_tools::PoseGraph>>> results;
+  const ros::Time now = ros::Time::now();
+  for (auto it = mPoseGraphQueries.begin(); it != mPoseGraphQueries.end();) {
+    PoseGraphQuery &query = *it;
+    if (query.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      auto pose_graph = query.result.get();
+      if (!query.abandoned) results.emplace_back(query.purpose, std::move(pose_graph));
+      it = mPoseGraphQueries.erase(it);
+      continue;
+    }
+    // roscpp service calls cannot time out, so this robot stops waiting for the result,
+    // e.g., when the nodelet manager of the front end has no free thread
+    if (!query.abandoned && mParamsROS.poseGraphQueryTimeout > 0 &&
+        (now - query.start_time).toSec() > mParamsROS.poseGraphQueryTimeout) {
+      ROS_ERROR("Robot %u pose graph query did not return within %.1f sec.",
+                getID(), mParamsROS.poseGraphQueryTimeout);
+      query.abandoned = true;
+      results.emplace_back(query.purpose, std::nullopt);
+    }
+    ++it;
   }
-  if (!ros::service::call(service_name, query)) {
-    ROS_ERROR_STREAM("Failed to call ROS service " << service_name);
-    return false;
+  for (const auto &result : results) {
+    const auto &pose_graph = result.second;
+    switch (result.first) {
+      case PoseGraphQuery::Purpose::Round:
+        finishRequestPoseGraph(pose_graph.has_value() && processPoseGraph(pose_graph.value()));
+        break;
+      case PoseGraphQuery::Purpose::OnlineUpdate:
+        if (pose_graph) updatePoseGraphOnline(pose_graph.value());
+        break;
+      case PoseGraphQuery::Purpose::Summary:
+        if (pose_graph) mLatestPoseGraphSummary = summarizePoseGraph(pose_graph.value(), getID());
+        break;
+    }
+  }
+}
+
+bool PGOAgentROS::roundPoseGraphQueryPending() const {
+  for (const auto &query : mPoseGraphQueries) {
+    if (query.purpose == PoseGraphQuery::Purpose::Round && !query.abandoned) return true;
+  }
+  return false;
+}
+
+unsigned PGOAgentROS::externalPoseIndex(unsigned index) const {
+  if (!mChainReduction) return index;
+  return mChainReduction->fullIndex(index);
+}
+
+bool PGOAgentROS::internalPoseIndex(unsigned external_index, unsigned &index) const {
+  if (!mChainReduction) {
+    index = external_index;
+    return true;
+  }
+  const int reduced_index = mChainReduction->reducedIndex(external_index);
+  if (reduced_index < 0) return false;
+  index = reduced_index;
+  return true;
+}
+
+RelativeSEMeasurement PGOAgentROS::externalMeasurement(const RelativeSEMeasurement &m) const {
+  if (!mChainReduction) return m;
+  return expandMeasurement(getID(), mChainReduction.value(), m);
+}
+
+bool PGOAgentROS::internalMeasurement(RelativeSEMeasurement &m) const {
+  if (!mChainReduction) return true;
+  return reduceMeasurement(getID(), mChainReduction.value(), m);
+}
+
+void PGOAgentROS::requestPoseGraph() {
+  if (!startPoseGraphQuery(PoseGraphQuery::Purpose::Round)) {
+    ROS_ERROR("Robot %u is still waiting for a previous pose graph query.", getID());
+    finishRequestPoseGraph(false);
   }
+}
 
-  pose_graph_tools::PoseGraph pose_graph = query.response.pose_graph;
+bool PGOAgentROS::processPoseGraph(const pose_graph_tools::PoseGraph &pose_graph) {
   if (pose_graph.edges.size() <= 1) {
     ROS_WARN("Received empty pose graph.");
     return false;
   }
+  mRoundPoseGraphSummary = summarizePoseGraph(pose_graph, getID());
+  mLatestPoseGraphSummary = mRoundPoseGraphSummary;
 
   // Process edges
-  unsigned int num_measurements_before = mPoseGraph->numMeasurements();
-  for (const auto &edge : pose_graph.edges) {
-    RelativeSEMeasurement m = RelativeMeasurementFromMsg(edge);
-    const PoseID src_id(m.r1, m.p1);
-    const PoseID dst_id(m.r2, m.p2);
+  std::vector<RelativeSEMeasurement> measurements = RelativeMeasurementsFromMsg(pose_graph.edges);
+  for (const auto &m : measurements) {
     if (m.r1 != getID() && m.r2 != getID()) {
       ROS_ERROR("Robot %u received irrelevant measurement! ", getID());
     }
-    if (!mPoseGraph->hasMeasurement(src_id, dst_id)) {
+  }
+  if (reuseDataMatrices()) {
+    // Data matrices kept from the previous round remain valid if the front end reports the same measurements
+    const MeasurementChanges changes = compareMeasurements(mRoundMeasurements, measurements);
+    if (changes.empty()) {
+      ROS_INFO("Robot %u pose graph is unchanged. Reuse data matrices.", getID());
+    } else if (changes.numRemoved > 0 || changes.numModified > 0) {
+      // The kept pose graph only receives new measurements, so it is rebuilt from the front end
+      ROS_INFO("Robot %u pose graph changes: %zu added, %zu removed, %zu modified. Rebuild pose graph.",
+               getID(), changes.numAdded, changes.numRemoved, changes.numModified);
+      mPoseGraph = std::make_shared<PoseGraph>(mID, r, d);
+    } else {
+      ROS_INFO("Robot %u pose graph changes: %zu added. Rebuild data matrices.", getID(), changes.numAdded);
+      mPoseGraph->clearDataMatrices();
+    }
+    mRoundMeasurements = measurements;
+  }
+  if (mParamsROS.reduceOdometryChains) {
+    // Reduced pose indices change as the pose graph grows, so the pose graph is rebuilt
+    mPoseGraph = std::make_shared<PoseGraph>(mID, r, d);
+    mChainReduction.emplace();
+    measurements = reduceOdometryChains(getID(), measurements, mParamsROS.keyframeInterval,
+                                        mChainReduction.value());
+    ROS_INFO("Robot %u reduced pose graph from %u to %u poses.",
+             getID(), mChainReduction->numPoses(), mChainReduction->numKeptPoses());
+  }
+  unsigned int num_measurements_before = mPoseGraph->numMeasurements();
+  for (const auto &m : measurements) {
+    if (!mPoseGraph->hasMeasurement(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2))) {
       addMeasurement(m);
     }
   }
   unsigned int num_measurements_after = mPoseGraph->numMeasurements();
+  if (!mCheckpointMeasurements.empty()) {
+    applyCheckpointWeights();
+  }
+  invalidatePublicPosesSendPlans();
+  mSentEdgeWeightTablesValid = false;
   ROS_INFO("Received pose graph from ROS service (%u new measurements).",
            num_measurements_after - num_measurements_before);
 
@@ -296,8 +668,8 @@ bool PGOAgentROS::requestPoseGraph() {
         assert((unsigned) node.robot_id == getID());
         size_t index = node.key;
         assert(index >= 0 && index < num_poses());
-        initial_poses.rotation(index) = RotationFromPoseMsg(node.pose);
-        initial_poses.translation(index) = TranslationFromPoseMsg(node.pose);
+        initial_poses.rotation(index) = RotationFromPoseMsg3d(node.pose);
+        initial_poses.translation(index) = TranslationFromPoseMsg3d(node.pose);
       }
     }
   }
@@ -319,6 +691,26 @@ bool PGOAgentROS::requestPoseGraph() {
   return true;
 }
 
+void PGOAgentROS::finishRequestPoseGraph(bool received_pose_graph) {
+  // Create log file for new round
+  if (mParams.logData && received_pose_graph) {
+    auto time_since_launch = ros::Time::now() - mLaunchTime;
+    int sec_since_launch = int(time_since_launch.toSec());
+    std::string log_path = mParams.logDirectory + "dpgo_log_" + std::to_string(sec_since_launch) + ".csv";
+    createIterationLog(log_path);
+  }
+  publishStatus();
+  // Enter initialization round
+  if (isLeader()) {
+    if (!received_pose_graph) {
+      publishHardTerminateCommand();
+    } else {
+      publishAnchor();
+      publishInitializeCommand();
+    }
+  }
+}
+
 bool PGOAgentROS::tryInitialize() {
   // Before initialization, we need to received inter-robot loop closures from
   // all preceeding robots.
@@ -345,7 +737,21 @@ bool PGOAgentROS::tryInitialize() {
              mPoseGraph->numSharedLoopClosures());
     
     // Perform local initialization
-    initialize(); 
+    // After a restart, initialize from the checkpointed trajectory (already in global frame)
+    const unsigned num_external_poses = mChainReduction ? mChainReduction->numPoses() : num_poses();
+    const bool warm_start = mWarmStartPending && mCachedPoses.has_value() &&
+                            mCachedPoses->n() == num_external_poses;
+    if (warm_start) {
+      ROS_INFO("Robot %u initializes from checkpoint.", getID());
+      PoseArray TInit(dimension(), num_poses());
+      for (unsigned index = 0; index < num_poses(); ++index) {
+        TInit.pose(index) = mCachedPoses->pose(externalPoseIndex(index));
+      }
+      initialize(&TInit);
+    } else {
+      initialize();
+    }
+    mWarmStartPending = false;
 
     // Leader first initializes in global frame
     if (isLeader()) {
@@ -354,7 +760,7 @@ bool PGOAgentROS::tryInitialize() {
       } else if (getID() != 0 && mCachedPoses.has_value()) {
         ROS_INFO("Leader %u initializes in global frame using previous result.", getID());
         const auto TPrev = mCachedPoses.value();
-        const Pose T_world_leader(TPrev.pose(0));
+        const Pose T_world_leader = warm_start ? Pose(d) : Pose(TPrev.pose(0));
         initializeInGlobalFrame(T_world_leader);
         initializeGlobalAnchor();
         anchorFirstPose();
@@ -372,7 +778,28 @@ bool PGOAgentROS::isRobotConnected(unsigned robot_id) const {
   if (robot_id == getID()) {
     return true;
   }
-  return mTeamConnected[robot_id];
+  return mTeamConnected[robot_id] && !isRobotSuspected(robot_id);
+}
+
+void PGOAgentROS::receivedHeartbeat(unsigned robot_id, const ros::Time &arrival) {
+  if (!mParamsROS.adaptiveFailureDetection || robot_id >= mParams.numRobots || robot_id == getID()) {
+    return;
+  }
+  PhiAccrualDetector &detector = mFailureDetectors[robot_id];
+  const double time = arrival.toSec();
+  if (detector.phi(time) > mParamsROS.phiThreshold) {
+    // Start a new history, so that the silent period does not make the detector tolerant
+    ROS_WARN("Robot %u receives messages from robot %u again.", getID(), robot_id);
+    detector.reset();
+  }
+  detector.heartbeat(time);
+}
+
+bool PGOAgentROS::isRobotSuspected(unsigned robot_id) const {
+  if (!mParamsROS.adaptiveFailureDetection || robot_id >= mParams.numRobots || robot_id == getID()) {
+    return false;
+  }
+  return mFailureDetectors[robot_id].phi(ros::Time::now().toSec()) > mParamsROS.phiThreshold;
 }
 
 void PGOAgentROS::setActiveRobots() {
@@ -405,8 +832,7 @@ void PGOAgentROS::publishLiftingMatrix() {
     ROS_WARN("Lifting matrix does not exist! ");
     return;
   }
-  MatrixMsg msg = MatrixToMsg(YLift);
-  mLiftingMatrixPublisher.publish(msg);
+  mTransport->publishLiftingMatrix(boost::make_shared<MatrixMsg>(MatrixToMsg(YLift)));
 }
 
 void PGOAgentROS::publishAnchor() {
@@ -428,31 +854,39 @@ void PGOAgentROS::publishAnchor() {
     }
     T0 = globalAnchor.value().getData();
   }
-  PublicPoses msg;
-  msg.robot_id = 0;
-  msg.instance_number = instance_number();
-  msg.iteration_number = iteration_number();
-  msg.cluster_id = getClusterID();
-  msg.is_auxiliary = false;
-  msg.pose_ids.push_back(0);
-  msg.poses.push_back(MatrixToMsg(T0));
+  PublicPosesPtr msg = boost::make_shared<PublicPoses>();
+  msg->robot_id = 0;
+  msg->instance_number = instance_number();
+  msg->iteration_number = iteration_number();
+  msg->cluster_id = getClusterID();
+  msg->is_auxiliary = false;
+  msg->pose_ids.push_back(0);
+  msg->poses.push_back(MatrixToMsg(T0));
 
-  mAnchorPublisher.publish(msg);
+  mTransport->publishAnchor(msg);
 }
 
 void PGOAgentROS::publishUpdateCommand() {
+  // This robot cannot take the next turn while its local solve is still running
+  auto isEligible = [this](unsigned robot_id) {
+    return isRobotActive(robot_id) && isRobotInitialized(robot_id) &&
+           !(robot_id == getID() && mLocalSolve.valid());
+  };
   unsigned selected_robot = 0;
   switch (mParamsROS.updateRule) {
     case PGOAgentROSParameters::UpdateRule::Uniform: {
       // Uniform sampling of all active robots
       std::vector<unsigned> active_robots;
       for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
-        if (isRobotActive(robot_id) && 
-            isRobotInitialized(robot_id)) {
+        if (isEligible(robot_id)) {
           active_robots.push_back(robot_id);
         }
       }
       size_t num_active_robots = active_robots.size();
+      if (num_active_robots == 0) {
+        publishRecoverCommand();
+        return;
+      }
       std::vector<double> weights(num_active_robots, 1.0);
       std::discrete_distribution<int> distribution(weights.begin(),
                                                    weights.end());
@@ -464,13 +898,57 @@ void PGOAgentROS::publishUpdateCommand() {
     case PGOAgentROSParameters::UpdateRule::RoundRobin: {
       // Round robin updates
       unsigned next_robot_id = (getID() + 1) % mParams.numRobots;
-      while (!isRobotActive(next_robot_id) ||
-             !isRobotInitialized(next_robot_id)) {
+      unsigned num_skipped = 0;
+      while (!isEligible(next_robot_id)) {
+        if (++num_skipped == mParams.numRobots) {
+          publishRecoverCommand();
+          return;
+        }
         next_robot_id = (next_robot_id + 1) % mParams.numRobots;
       }
       selected_robot = next_robot_id;
       break;
     }
+    case PGOAgentROSParameters::UpdateRule::LoadBalanced: {
+      // Sample robots by expected cost decrease per second of their local optimization
+      const unsigned current_iteration = mLocalSolve.valid() ? mLocalSolveIteration : iteration_number();
+      std::vector<unsigned> active_robots;
+      std::vector<RobotUpdateStatistics> stats;
+      for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+        if (!isEligible(robot_id)) continue;
+        RobotUpdateStatistics stat;
+        if (robot_id == getID()) {
+          if (mLastOptimizedIteration > 0) {
+            stat.valid = true;
+            stat.costDecrease = mLocalOptResult.fInit - mLocalOptResult.fOpt;
+            stat.elapsedMs = mIterationElapsedMs;
+            stat.staleness = current_iteration - mLastOptimizedIteration;
+          }
+        } else {
+          const auto &it = mTeamStatusMsg.find(robot_id);
+          if (it != mTeamStatusMsg.end() && it->second.optimized_iteration > 0 &&
+              it->second.optimized_iteration <= current_iteration &&
+              it->second.instance_number == instance_number()) {
+            stat.valid = true;
+            stat.costDecrease = it->second.cost_decrease;
+            stat.elapsedMs = it->second.iteration_elapsed_ms;
+            stat.staleness = current_iteration - it->second.optimized_iteration;
+          }
+        }
+        active_robots.push_back(robot_id);
+        stats.push_back(stat);
+      }
+      if (active_robots.empty()) {
+        publishRecoverCommand();
+        return;
+      }
+      const std::vector<double> weights = loadBalancedUpdateWeights(stats, mParamsROS.loadBalanceMinWeight);
+      std::discrete_distribution<int> distribution(weights.begin(), weights.end());
+      std::random_device rd;
+      std::mt19937 gen(rd());
+      selected_robot = active_robots[distribution(gen)];
+      break;
+    }
   }
   if (selected_robot == getID()) {
     ROS_WARN("[publishUpdateCommand] Robot %u selects self to update next!", getID());
@@ -490,57 +968,59 @@ void PGOAgentROS::publishUpdateCommand(unsigned robot_id) {
   }
   if (mParamsROS.interUpdateSleepTime > 1e-3)
     ros::Duration(mParamsROS.interUpdateSleepTime).sleep();
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.command = Command::UPDATE;
-  msg.cluster_id = getClusterID();
-  msg.publishing_robot = getID();
-  msg.executing_robot = robot_id;
-  msg.executing_iteration = iteration_number() + 1;
-  ROS_INFO_STREAM("Send UPDATE to robot " << msg.executing_robot
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->command = Command::UPDATE;
+  msg->cluster_id = getClusterID();
+  msg->publishing_robot = getID();
+  msg->executing_robot = robot_id;
+  // The iteration counter belongs to the worker thread while the local solve is running
+  msg->executing_iteration = (mLocalSolve.valid() ? mLocalSolveIteration : iteration_number()) + 1;
+  msg->time_budget_ms = localSolveTimeBudget();
+  ROS_INFO_STREAM("Send UPDATE to robot " << msg->executing_robot
                                           << " to perform iteration "
-                                          << msg.executing_iteration << ".");
-  mCommandPublisher.publish(msg);
+                                          << msg->executing_iteration << ".");
+  publishAcknowledgedCommand(msg);
 }
 
 void PGOAgentROS::publishRecoverCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::RECOVER;
-  msg.executing_iteration = iteration_number();
-  mCommandPublisher.publish(msg);
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::RECOVER;
+  msg->executing_iteration = iteration_number();
+  mTransport->publishCommand(msg);
   ROS_INFO("Robot %u published RECOVER command.", getID());
 }
 
 void PGOAgentROS::publishTerminateCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::TERMINATE;
-  mCommandPublisher.publish(msg);
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::TERMINATE;
+  publishAcknowledgedCommand(msg);
   ROS_INFO("Robot %u published TERMINATE command.", getID());
 }
 
 void PGOAgentROS::publishHardTerminateCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::HARD_TERMINATE;
-  mCommandPublisher.publish(msg);
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::HARD_TERMINATE;
+  mTransport->publishCommand(msg);
   ROS_INFO("Robot %u published HARD TERMINATE command.", getID());
 }
 
 void PGOAgentROS::publishUpdateWeightCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::UPDATE_WEIGHT;
-  mCommandPublisher.publish(msg);
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::UPDATE_WEIGHT;
+  publishAcknowledgedCommand(msg);
   ROS_INFO("Robot %u published UPDATE_WEIGHT command (num inner iters %i).", 
            getID(), mRobustOptInnerIter);
 }
@@ -555,17 +1035,21 @@ void PGOAgentROS::publishRequestPoseGraphCommand() {
     ROS_WARN("Not enough active robots. Do not publish request pose graph command.");
     return;
   }
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::REQUEST_POSE_GRAPH;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::REQUEST_POSE_GRAPH;
   for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
     if (isRobotActive(robot_id)) {
-      msg.active_robots.push_back(robot_id);
+      msg->active_robots.push_back(robot_id);
     }
   }
-  mCommandPublisher.publish(msg);
+  if (mParamsROS.adaptiveRelaxationRank) {
+    msg->relaxation_rank = mRankIncreasePending ? r + 1 : r;
+    mRankIncreasePending = false;
+  }
+  mTransport->publishCommand(msg);
   ROS_INFO("Robot %u published REQUEST_POSE_GRAPH command.", getID());
 }
 
@@ -573,12 +1057,12 @@ void PGOAgentROS::publishInitializeCommand() {
   if (!isLeader()) {
     ROS_ERROR("Only leader should send INITIALIZE command!");
   }
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::INITIALIZE;
-  mCommandPublisher.publish(msg);
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::INITIALIZE;
+  publishAcknowledgedCommand(msg);
   mInitStepsDone++;
   mPublishInitializeCommandRequested = false;
   ROS_INFO("Robot %u published INITIALIZE command.", getID());
@@ -589,56 +1073,132 @@ void PGOAgentROS::publishActiveRobotsCommand() {
     ROS_ERROR("Only leader should publish active robots!");
     return;
   }
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::SET_ACTIVE_ROBOTS;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::SET_ACTIVE_ROBOTS;
   for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
     if (isRobotActive(robot_id)) {
-      msg.active_robots.push_back(robot_id);
+      msg->active_robots.push_back(robot_id);
     }
   }
 
-  mCommandPublisher.publish(msg);
+  mTransport->publishCommand(msg);
 }
 
 void PGOAgentROS::publishNoopCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::NOOP;
-  mCommandPublisher.publish(msg);
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::NOOP;
+  mTransport->publishCommand(msg);
+}
+
+void PGOAgentROS::publishAcknowledgedCommand(const CommandPtr &msg) {
+  if (mParamsROS.maxCommandRetransmissions <= 0) {
+    mTransport->publishCommand(msg);
+    return;
+  }
+  std::vector<unsigned> recipients;
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    if (isRobotActive(robot_id)) recipients.push_back(robot_id);
+  }
+  mCommandChannel->publish(msg, recipients, ros::Time::now().toSec());
+}
+
+void PGOAgentROS::retransmitCommands() {
+  const auto retransmissions = mCommandChannel->retransmit(
+      ros::Time::now().toSec(), mParamsROS.commandAckTimeout, std::max(0, mParamsROS.maxCommandRetransmissions),
+      [this](unsigned robot_id) { return isRobotActive(robot_id); });
+  for (const auto &retransmission : retransmissions) {
+    if (retransmission.abandoned) {
+      // Fall back to the timeout and recovery
+      ROS_WARN("Robot %u gives up command %u (type %u) after %u retransmissions (%zu robots did not acknowledge).",
+               getID(), retransmission.msg->sequence_number, retransmission.msg->command,
+               retransmission.num_retransmissions, retransmission.num_unacked_robots);
+    } else {
+      ROS_WARN("Robot %u retransmits command %u (type %u, attempt %u, %zu robots did not acknowledge).",
+               getID(), retransmission.msg->sequence_number, retransmission.msg->command,
+               retransmission.num_retransmissions, retransmission.num_unacked_robots);
+    }
+  }
 }
 
 void PGOAgentROS::publishStatus() {
-  Status msg = statusToMsg(getStatus());
+  // The worker thread writes the status, the iterate and the result of the local solve,
+  // so resend the status taken before the local solve with the current acknowledgements
+  if (mLocalSolve.valid()) {
+    if (!mStatusSnapshot) return;
+    StatusPtr msg = boost::make_shared<Status>(*mStatusSnapshot);
+    fillStatusAcknowledgements(*msg);
+    mTransport->publishStatus(msg);
+    return;
+  }
+  StatusPtr msg = boost::make_shared<Status>(statusToMsg(getStatus()));
+  msg->optimized_iteration = mLastOptimizedIteration;
+  if (mLastOptimizedIteration > 0) {
+    msg->cost_decrease = mLocalOptResult.fInit - mLocalOptResult.fOpt;
+    msg->gradnorm = mLocalOptResult.gradNormOpt;
+  }
+  msg->weight_change = mLastWeightChange;
+  msg->num_pose_graph_edges = mLatestPoseGraphSummary.numEdges;
+  if (mLatestPoseGraphSummary.numEdges > mRoundPoseGraphSummary.numEdges)
+    msg->num_new_edges = mLatestPoseGraphSummary.numEdges - mRoundPoseGraphSummary.numEdges;
+  if (mLatestPoseGraphSummary.numLoopClosures > mRoundPoseGraphSummary.numLoopClosures)
+    msg->num_new_loop_closures = mLatestPoseGraphSummary.numLoopClosures - mRoundPoseGraphSummary.numLoopClosures;
+  msg->iteration_elapsed_ms = mIterationElapsedMs;
+  if (mParamsROS.adaptiveRelaxationRank && mState == PGOAgentState::INITIALIZED) {
+    const Matrix gram = liftedRotationGram(X);
+    msg->lifted_gram.resize(gram.size());
+    Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(
+        msg->lifted_gram.data(), gram.rows(), gram.cols()) = gram;
+  }
+  if (mParamsROS.leaderFailover && isLeader()) {
+    msg->weight_update_count = mWeightUpdateCount;
+    msg->robust_opt_inner_iter = mRobustOptInnerIter;
+  }
+  mStatusSnapshot = boost::make_shared<Status>(*msg);
+  fillStatusAcknowledgements(*msg);
+  mTransport->publishStatus(msg);
+}
+
+void PGOAgentROS::fillStatusAcknowledgements(Status &msg) {
   msg.cluster_id = getClusterID();
   msg.header.stamp = ros::Time::now();
-  mStatusPublisher.publish(msg);
+  mCommandChannel->fillAcknowledgements(msg);
+  msg.weight_table_requests.clear();
+  for (const auto &it : mReceivedEdgeWeightTables) {
+    if (it.second.full_table_requested) msg.weight_table_requests.push_back(it.first);
+  }
+  mCommandAckRequested = false;
 }
 
 void PGOAgentROS::storeOptimizedTrajectory() {
   PoseArray T(dimension(), num_poses());
   if (getTrajectoryInGlobalFrame(T)) {
-    mCachedPoses.emplace(T);
+    // Recover poses removed by odometry chain reduction
+    if (mChainReduction) {
+      mCachedPoses.emplace(expandTrajectory(mChainReduction.value(), T));
+    } else {
+      mCachedPoses.emplace(T);
+    }
   }
 }
 
 void PGOAgentROS::publishTrajectory(const PoseArray &T) {
   // Publish as pose array
-  geometry_msgs::PoseArray pose_array =
-      TrajectoryToPoseArray(T.d(), T.n(), T.getData());
-  mPoseArrayPublisher.publish(pose_array);
+  mPoseArrayPublisher.publish(boost::make_shared<geometry_msgs::PoseArray>(
+      TrajectoryToPoseArray(T.d(), T.n(), T.getData())));
 
   // Publish as path
-  nav_msgs::Path path = TrajectoryToPath(T.d(), T.n(), T.getData());
-  mPathPublisher.publish(path);
+  mPathPublisher.publish(boost::make_shared<nav_msgs::Path>(
+      TrajectoryToPath(T.d(), T.n(), T.getData())));
 
   // Publish as optimized pose graph
-  pose_graph_tools::PoseGraph pose_graph = TrajectoryToPoseGraphMsg(getID(), T.d(), T.n(), T.getData());
-  mPoseGraphPublisher.publish(pose_graph);
+  mPoseGraphPublisher.publish(boost::make_shared<pose_graph_tools::PoseGraph>(
+      TrajectoryToPoseGraphMsg(getID(), T.d(), T.n(), T.getData())));
 }
 
 void PGOAgentROS::publishOptimizedTrajectory() {
@@ -655,55 +1215,108 @@ void PGOAgentROS::publishIterate() {
   }
   PoseArray T(dimension(), num_poses());
   if (getTrajectoryInGlobalFrame(T)) {
-    publishTrajectory(T);
+    publishTrajectory(mChainReduction ? expandTrajectory(mChainReduction.value(), T) : T);
   }
 }
 
 void PGOAgentROS::publishPublicPoses(bool aux) {
-  for (unsigned neighbor : getNeighbors()) {
-    PoseDict map;
-    if (aux) {
-      if (!getAuxSharedPoseDictWithNeighbor(map, neighbor)) return;
+  if (mState != PGOAgentState::INITIALIZED) return;
+  if (!mPublicPosesSendPlansValid) buildPublicPosesSendPlans();
+
+  for (auto &plan : mPublicPosesSendPlans) {
+    if (!isRobotActive(plan.neighbor_id)) continue;
+    unsigned &next = aux ? plan.next_aux_msg : plan.next_msg;
+    PublicPosesPtr &msg = aux ? plan.aux_msgs[next] : plan.msgs[next];
+    // Intra-process subscribers only hold on to the message before the last one if they
+    // fall behind, in which case we must not modify it in place
+    if (!msg.unique()) msg = boost::make_shared<PublicPoses>(*msg);
+
+    msg->cluster_id = getClusterID();
+    msg->instance_number = instance_number();
+    msg->iteration_number = iteration_number();
+    bool success = true;
+    for (size_t k = 0; success && k < plan.pose_indices.size(); ++k) {
+      success = aux ? getAuxSharedPose(plan.pose_indices[k], mSharedPoseBuffer)
+                    : getSharedPose(plan.pose_indices[k], mSharedPoseBuffer);
+      if (success) MatrixToMsg(mSharedPoseBuffer, msg->poses[k]);
+    }
+    // Skip this neighbor, the half-written message is overwritten by the next publish
+    if (!success) continue;
+    mTransport->publishPublicPoses(msg);
+    next = 1 - next;
+  }
+}
+
+void PGOAgentROS::buildPublicPosesSendPlans() {
+  // Collect the local poses involved in shared loop closures with each neighbor.
+  // Loop closures rejected by GNC do not need the poses of this robot.
+  // Neighbors whose loop closures are all rejected still receive (empty) messages
+  // that keep their iteration bookkeeping up to date.
+  std::map<unsigned, std::set<unsigned>> neighbor_pose_indices;
+  for (const auto &m : mPoseGraph->sharedLoopClosures()) {
+    const bool rejected = m.fixedWeight && m.weight == 0;
+    if (m.r1 == getID()) {
+      auto &indices = neighbor_pose_indices[m.r2];
+      if (!rejected) indices.insert(m.p1);
     } else {
-      if (!getSharedPoseDictWithNeighbor(map, neighbor)) return;
+      auto &indices = neighbor_pose_indices[m.r1];
+      if (!rejected) indices.insert(m.p2);
     }
-    if (map.empty())
-      continue;
+  }
+
+  mPublicPosesSendPlans.clear();
+  mPublicPosesSendPlans.reserve(neighbor_pose_indices.size());
+  for (const auto &it : neighbor_pose_indices) {
+    PublicPosesSendPlan plan;
+    plan.neighbor_id = it.first;
+    plan.pose_indices.assign(it.second.begin(), it.second.end());
 
     PublicPoses msg;
     msg.robot_id = getID();
-    msg.cluster_id = getClusterID();
-    msg.destination_robot_id = neighbor;
-    msg.instance_number = instance_number();
-    msg.iteration_number = iteration_number();
-    msg.is_auxiliary = aux;
-
-    for (const auto &sharedPose : map) {
-      const PoseID nID = sharedPose.first;
-      const auto &matrix = sharedPose.second.getData();
-      CHECK_EQ(nID.robot_id, getID());
-      msg.pose_ids.push_back(nID.frame_id);
-      msg.poses.push_back(MatrixToMsg(matrix));
+    msg.destination_robot_id = plan.neighbor_id;
+    for (unsigned index : plan.pose_indices) msg.pose_ids.push_back(externalPoseIndex(index));
+    msg.poses.resize(plan.pose_indices.size());
+    for (auto &pose_msg : msg.poses) {
+      pose_msg.rows = r;
+      pose_msg.cols = d + 1;
+      pose_msg.values.resize(r * (d + 1));
     }
-    mPublicPosesPublisher.publish(msg);
+    msg.is_auxiliary = false;
+    for (auto &plan_msg : plan.msgs) plan_msg = boost::make_shared<PublicPoses>(msg);
+    if (mParams.acceleration) {
+      msg.is_auxiliary = true;
+      for (auto &plan_msg : plan.aux_msgs) plan_msg = boost::make_shared<PublicPoses>(msg);
+    }
+    mPublicPosesSendPlans.push_back(plan);
   }
+  mSharedPoseBuffer = Matrix::Zero(r, d + 1);
+  mPublicPosesSendPlansValid = true;
+}
+
+void PGOAgentROS::invalidatePublicPosesSendPlans() {
+  mPublicPosesSendPlans.clear();
+  mPublicPosesSendPlansValid = false;
 }
 
 void PGOAgentROS::publishPublicMeasurements() {
+  publishPublicMeasurements(mPoseGraph->sharedLoopClosures());
+}
+
+void PGOAgentROS::publishPublicMeasurements(const std::vector<RelativeSEMeasurement> &shared_loop_closures) {
   if (!mParamsROS.synchronizeMeasurements) {
     // Do not publish shared measurements 
     // when assuming measurements are already synched
     return;
   }
-  std::map<unsigned, RelativeMeasurementList> msg_map;
+  std::map<unsigned, RelativeMeasurementListPtr> msg_map;
   for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
-    RelativeMeasurementList msg;
-    msg.from_robot = getID();
-    msg.from_cluster = getClusterID();
-    msg.to_robot = robot_id;
+    RelativeMeasurementListPtr msg = boost::make_shared<RelativeMeasurementList>();
+    msg->from_robot = getID();
+    msg->from_cluster = getClusterID();
+    msg->to_robot = robot_id;
     msg_map[robot_id] = msg;
   }
-  for (const auto &m : mPoseGraph->sharedLoopClosures()) {
+  for (const auto &m : shared_loop_closures) {
     unsigned otherID = 0;
     if (m.r1 == getID()) {
       otherID = m.r2;
@@ -711,48 +1324,97 @@ void PGOAgentROS::publishPublicMeasurements() {
       otherID = m.r1;
     }
     CHECK(msg_map.find(otherID) != msg_map.end());
-    const auto edge = RelativeMeasurementToMsg(m);
-    msg_map[otherID].edges.push_back(edge);
+    const auto edge = RelativeMeasurementToMsg(externalMeasurement(m));
+    msg_map[otherID]->edges.push_back(edge);
   }
   for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id)
-    mPublicMeasurementsPublisher.publish(msg_map[robot_id]);
+    mTransport->publishPublicMeasurements(msg_map[robot_id]);
 }
 
-void PGOAgentROS::publishMeasurementWeights() {
+void PGOAgentROS::publishMeasurementWeights(bool full_table) {
   // if (mState != PGOAgentState::INITIALIZED) return;
+  if (!mSentEdgeWeightTablesValid) buildSentEdgeWeightTables();
+
+  const auto &shared_loop_closures = mPoseGraph->sharedLoopClosures();
+  for (auto &it : mSentEdgeWeightTables) {
+    const unsigned otherID = it.first;
+    auto &table = it.second;
+    // The first message of a round always contains the full table
+    const bool send_full_table = full_table || table.version == 0 || table.full_table_requested;
+    table.full_table_requested = false;
+
+    RelativeMeasurementWeightsPtr msg = boost::make_shared<RelativeMeasurementWeights>();
+    msg->robot_id = getID();
+    msg->cluster_id = getClusterID();
+    msg->destination_robot_id = otherID;
+    msg->base_version = send_full_table ? 0 : table.version;
+    msg->version = table.version + 1;
+    msg->table_size = table.edges.size();
+    for (size_t k = 0; k < table.edges.size(); ++k) {
+      const auto &m = shared_loop_closures[table.measurement_indices[k]];
+      const float weight = m.weight;
+      const bool fixed = m.fixedWeight;
+      if (!send_full_table && weight == table.weights[k] && fixed == table.fixed_weights[k]) {
+        continue;
+      }
+      if (send_full_table) {
+        const auto external_m = externalMeasurement(m);
+        msg->src_robot_ids.push_back(external_m.r1);
+        msg->dst_robot_ids.push_back(external_m.r2);
+        msg->src_pose_ids.push_back(external_m.p1);
+        msg->dst_pose_ids.push_back(external_m.p2);
+      } else {
+        msg->edge_indices.push_back(k);
+      }
+      msg->weights.push_back(weight);
+      msg->fixed_weights.push_back(fixed);
+      table.weights[k] = weight;
+      table.fixed_weights[k] = fixed;
+    }
+    if (msg->weights.empty()) continue;
+    table.version = msg->version;
+    mTransport->publishMeasurementWeights(msg);
+  }
+}
 
-  std::map<unsigned, RelativeMeasurementWeights> msg_map;
-  for (const auto &m : mPoseGraph->sharedLoopClosures()) {
+void PGOAgentROS::buildSentEdgeWeightTables() {
+  mSentEdgeWeightTables.clear();
+  const auto &shared_loop_closures = mPoseGraph->sharedLoopClosures();
+  for (size_t index = 0; index < shared_loop_closures.size(); ++index) {
+    const auto &m = shared_loop_closures[index];
     unsigned otherID = 0;
     if (m.r1 == getID()) {
       otherID = m.r2;
     } else {
       otherID = m.r1;
     }
+    // This robot is responsible for loop closures with robots of larger IDs
     if (otherID > getID()) {
-      if (msg_map.find(otherID) == msg_map.end()) {
-        RelativeMeasurementWeights msg;
-        msg.robot_id = getID();
-        msg.cluster_id = getClusterID();
-        msg.destination_robot_id = otherID;
-        msg_map[otherID] = msg;
-      }
-      msg_map[otherID].src_robot_ids.push_back(m.r1);
-      msg_map[otherID].dst_robot_ids.push_back(m.r2);
-      msg_map[otherID].src_pose_ids.push_back(m.p1);
-      msg_map[otherID].dst_pose_ids.push_back(m.p2);
-      msg_map[otherID].weights.push_back(m.weight);
-      msg_map[otherID].fixed_weights.push_back(m.fixedWeight);
+      auto &table = mSentEdgeWeightTables[otherID];
+      table.edges.emplace_back(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2));
+      table.measurement_indices.push_back(index);
+      table.weights.push_back(m.weight);
+      table.fixed_weights.push_back(m.fixedWeight);
     }
   }
-  for (const auto &it : msg_map) {
-    const auto &msg = it.second;
-    if (!msg.weights.empty()) {
-      mMeasurementWeightsPublisher.publish(msg);
-    }
+  mSentEdgeWeightTablesValid = true;
+}
+
+void PGOAgentROS::refreshDataMatrices() {
+  if (mDataMatricesStale) {
+    // Recompute data matrices in the pose graph once for all received weight changes
+    mPoseGraph->clearDataMatrices();
+    mDataMatricesStale = false;
   }
 }
 
+bool PGOAgentROS::reuseDataMatrices() const {
+  // Robust costs reweight measurements within each round
+  return mParamsROS.reuseDataMatrices &&
+         mParams.robustCostParams.costType == RobustCostParameters::Type::L2 &&
+         !mParamsROS.completeReset && !mParamsROS.reduceOdometryChains;
+}
+
 void PGOAgentROS::storeLoopClosureMarkers() {
   if (mState != PGOAgentState::INITIALIZED) return;
   double weight_tol = mParamsROS.weightConvergenceThreshold;
@@ -842,12 +1504,26 @@ void PGOAgentROS::storeLoopClosureMarkers() {
     mCachedLoopClosureMarkers.emplace(line_list);
 }
 
+void PGOAgentROS::schedulePublishResults() {
+  // Copy the results, which a complete reset clears before they are published
+  std::optional<PoseArray> poses;
+  if (isRobotActive(getID())) poses = mCachedPoses;
+  std::optional<visualization_msgs::Marker> markers;
+  if (mParamsROS.visualizeLoopClosures) markers = mCachedLoopClosureMarkers;
+  const ros::Duration delay = randomDuration(0.1, 5);
+  mPublishResultsTimer = nh.createTimer(delay, [this, poses, markers](const ros::TimerEvent &event) {
+    if (poses) publishTrajectory(poses.value());
+    if (markers) mLoopClosureMarkerPublisher.publish(boost::make_shared<visualization_msgs::Marker>(markers.value()));
+  }, true);
+}
+
 void PGOAgentROS::publishLoopClosureMarkers() {
   if (!mParamsROS.visualizeLoopClosures) {
     return;
   }
   if (mCachedLoopClosureMarkers.has_value())
-    mLoopClosureMarkerPublisher.publish(mCachedLoopClosureMarkers.value());
+    mLoopClosureMarkerPublisher.publish(
+        boost::make_shared<visualization_msgs::Marker>(mCachedLoopClosureMarkers.value()));
 }
 
 bool PGOAgentROS::createIterationLog(const std::string &filename) {
@@ -922,18 +1598,24 @@ void PGOAgentROS::connectivityCallback(
 }
 
 void PGOAgentROS::liftingMatrixCallback(const MatrixMsgConstPtr &msg) {
+  if (deferCallback([this, msg]() { liftingMatrixCallback(msg); }, false)) return;
   // if (mParams.verbose) {
   //   ROS_INFO("Robot %u receives lifting matrix.", getID());
   // }
+  // Ignore lifting matrices of a previous relaxation rank
+  if (msg->rows != r) {
+    return;
+  }
   setLiftingMatrix(MatrixFromMsg(*msg));
 }
 
 void PGOAgentROS::anchorCallback(const PublicPosesConstPtr &msg) {
+  if (deferCallback([this, msg]() { anchorCallback(msg); }, false)) return;
   if (msg->robot_id != 0 || msg->pose_ids[0] != 0) {
     ROS_ERROR("Received wrong pose as anchor!");
     return;
   }
-  if (msg->cluster_id != getClusterID()) {
+  if (msg->cluster_id != getClusterID() || msg->poses[0].rows != r) {
     return;
   }
   setGlobalAnchor(MatrixFromMsg(msg->poses[0]));
@@ -959,17 +1641,38 @@ void PGOAgentROS::statusCallback(const StatusConstPtr &msg) {
     }
   }
   mTeamStatusMsg[msg->robot_id] = received_msg;
+  mCommandChannel->acknowledge(received_msg);
+
+  // Resend the full weight table to neighbors that missed an update
+  for (const auto &robot_id : msg->weight_table_requests) {
+    if (robot_id != getID()) continue;
+    const auto table = mSentEdgeWeightTables.find(msg->robot_id);
+    if (table != mSentEdgeWeightTables.end()) table->second.full_table_requested = true;
+  }
   
   setRobotClusterID(msg->robot_id, msg->cluster_id);
   if (msg->cluster_id == getClusterID()) {
     setNeighborStatus(statusFromMsg(received_msg));;
+    // Decreases from before the latest weight update belong to a different cost
+    if (tracksLeaderState() && mParamsROS.predictiveTermination &&
+        msg->optimized_iteration > mPredictorStartIteration) {
+      mConvergencePredictor.addCostDecrease(msg->optimized_iteration, msg->cost_decrease);
+    }
+    // Replicate the GNC counters of the leader, so that the successor makes the same decisions after a takeover
+    if (mParamsROS.leaderFailover && msg->robot_id == getClusterID() && !isLeader() &&
+        tracksLeaderState() && msg->state == Status::INITIALIZED &&
+        msg->instance_number == instance_number() && !mLocalSolve.valid()) {
+      mWeightUpdateCount = msg->weight_update_count;
+      mRobustOptInnerIter = msg->robust_opt_inner_iter;
+    }
   } 
 
   // Edge cases in synchronous mode
   if (!mParams.asynchronous) {
     if (isLeader() && isRobotActive(msg->robot_id)) {
       bool should_deactivate = false;
-      if (msg->cluster_id != getClusterID()) {
+      // Robots that have not yet followed the takeover still report the failed leader
+      if (msg->cluster_id != getClusterID() && msg->cluster_id != mFailedLeaderID) {
         ROS_WARN("Robot %u joined other cluster %u... set to inactive.", msg->robot_id, msg->cluster_id);
         should_deactivate = true;
       }
@@ -986,6 +1689,13 @@ void PGOAgentROS::statusCallback(const StatusConstPtr &msg) {
 }
 
 void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
+  // Commands of a new round are handled once this robot received its pose graph
+  // RECOVER resets the iteration number, so it waits for the local solve without blocking
+  if (deferCallback([this, msg]() { commandCallback(msg); }, msg->command == Command::RECOVER)) return;
+  // The successor of a failed leader moves the cluster to itself
+  if (msg->command == Command::TAKEOVER && !acceptLeaderTakeover(msg)) {
+    return;
+  }
   if (msg->cluster_id != getClusterID()) {
     ROS_WARN_THROTTLE(1, "Ignore command from wrong cluster (recv %u, expect %u).",
                       msg->cluster_id, getClusterID());
@@ -996,6 +1706,20 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
   if (msg->command != Command::NOOP && msg->command != Command::SET_ACTIVE_ROBOTS) {
     mLastCommandTime = ros::Time::now();
   }
+  // Acknowledge commands with the next status, and drop retransmitted duplicates
+  if (msg->sequence_number > 0 && msg->publishing_robot < mParams.numRobots) {
+    if (msg->publishing_robot != getID()) mCommandAckRequested = true;
+    if (!mCommandChannel->receive(*msg)) {
+      return;
+    }
+    // Termination resets this robot before the next status, so it is acknowledged right away
+    if (msg->command == Command::TERMINATE && mCommandAckRequested) publishStatus();
+  }
+  // Only updates of other robots are handled while the local solve is running
+  if (mLocalSolve.valid() && msg->command != Command::NOOP &&
+      !(msg->command == Command::UPDATE && msg->executing_robot != getID())) {
+    waitForLocalSolve();
+  }
 
   switch (msg->command) {
     case Command::REQUEST_POSE_GRAPH: {
@@ -1011,25 +1735,12 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
       }
       // Update local record of currently active robots
       updateActiveRobots(msg);
-      // Request latest pose graph
-      bool received_pose_graph = requestPoseGraph();
-      // Create log file for new round
-      if (mParams.logData && received_pose_graph) {
-        auto time_since_launch = ros::Time::now() - mLaunchTime;
-        int sec_since_launch = int(time_since_launch.toSec());
-        std::string log_path = mParams.logDirectory + "dpgo_log_" + std::to_string(sec_since_launch) + ".csv";
-        createIterationLog(log_path);
-      }
-      publishStatus();
-      // Enter initialization round
-      if (isLeader()) {
-        if (!received_pose_graph) {
-          publishHardTerminateCommand();
-        } else {
-          publishAnchor();
-          publishInitializeCommand();
-        }
+      // Adopt the relaxation rank of the leader
+      if (mParamsROS.adaptiveRelaxationRank && msg->relaxation_rank > 0) {
+        setRelaxationRank(msg->relaxation_rank);
       }
+      // Request latest pose graph, the round continues once it is received
+      requestPoseGraph();
       break;
     }
 
@@ -1040,21 +1751,17 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
         break;
       }
       logString("TERMINATE");
+      if (mRankIncreaseCheckPending) {
+        mRankIncreasePending = relaxationRankIncreaseRequired();
+        mRankIncreaseCheckPending = false;
+      }
+      processPublicPosesMailbox();
       // When running distributed GNC, fix loop closures that have converged
       if (mParams.robustCostParams.costType ==
           RobustCostParameters::Type::GNC_TLS) {
-        double residual = 0;
-        double weight = 0;
-        for (auto &m : mPoseGraph->activeLoopClosures()) {
-          if (!m->fixedWeight && computeMeasurementResidual(*m, &residual)) {
-            weight = mRobustCost.weight(residual);
-            if (weight < mParamsROS.weightConvergenceThreshold) {
-              ROS_INFO("Reject measurement with residual %f and weight %f.", residual, weight);
-              m->weight = 0;
-              m->fixedWeight = true;
-            } 
-          }
-        }
+        const auto weight_stat = rejectConvergedOutliers(false);
+        ROS_INFO("Robot %u rejected %zu/%zu loop closures (max residual %f).",
+                 getID(), weight_stat.num_rejected, weight_stat.num_evaluated, weight_stat.max_residual);
         const auto stat = mPoseGraph->statistics();
         ROS_INFO(
             "Robot %u loop closure statistics:\n "
@@ -1073,10 +1780,9 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
       storeLoopClosureMarkers();
       storeActiveNeighborPoses();
       storeActiveEdgeWeights();
+      saveCheckpoint();
 
-      randomSleep(0.1, 5);
-      publishOptimizedTrajectory();
-      publishLoopClosureMarkers();
+      schedulePublishResults();
       reset();
       break;
     }
@@ -1103,7 +1809,6 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
         publishLiftingMatrix();
         // updateActiveRobots();
         publishActiveRobotsCommand();
-        ros::Duration(0.1).sleep();
 
         // Check the status of all robots
         bool all_initialized = true;
@@ -1172,6 +1877,11 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
       }
       // Update local record
       mTeamIterRequired[msg->executing_robot] = msg->executing_iteration;
+      if (mLocalSolve.valid()) {
+        // Iterate once the local solve finishes
+        mDeferredPassiveIterations++;
+        break;
+      }
       if (msg->executing_iteration != iteration_number() + 1) {
         ROS_WARN("Update iteration does not match local iteration. (received: %u, local: %u)",
                  msg->executing_iteration,
@@ -1179,9 +1889,11 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
       }
       if (msg->executing_robot == getID()) {
         mSynchronousOptimizationRequested = true;
+        mLocalSolveTimeBudgetMs = msg->time_budget_ms;
         if (mParams.verbose) ROS_INFO("Robot %u to update at iteration %u.", getID(), msg->executing_iteration);
       } else {
         // Agents that are not selected for optimization can iterate immediately
+        processPublicPosesMailbox();
         iterate(false);
         publishStatus();
       }
@@ -1190,21 +1902,16 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
 
     case Command::RECOVER: {
       CHECK(!mParams.asynchronous);
-      if (!isRobotActive(getID()) || mState != PGOAgentState::INITIALIZED) {
-        return;
-      }
-      mIterationNumber = msg->executing_iteration;
-      mSynchronousOptimizationRequested = false;
-      for (const auto &neighbor : getNeighbors()) {
-        mTeamIterRequired[neighbor] = iteration_number();
-        mTeamIterReceived[neighbor] = 0;  // Force robot to wait for updated public poses from neighbors
-      }
-      ROS_WARN("Robot %u received RECOVER command and reset iteration number to %u.", getID(), iteration_number());
+      ROS_WARN("Robot %u received RECOVER command.", getID());
+      resumeOptimization(msg->executing_iteration);
+      break;
+    }
 
-      if (isLeader()) {
-        ROS_WARN("Leader %u publishes update command.", getID());
-        publishUpdateCommand(getID());
-      }
+    case Command::TAKEOVER: {
+      CHECK(!mParams.asynchronous);
+      ROS_WARN("Robot %u received TAKEOVER command from robot %u.", getID(), msg->publishing_robot);
+      updateActiveRobots(msg);
+      resumeOptimization(msg->executing_iteration);
       break;
     }
 
@@ -1215,7 +1922,39 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
         return;
       }
       logString("UPDATE_WEIGHT");
+      processPublicPosesMailbox();
+      std::unordered_map<const RelativeSEMeasurement *, double> weights_before;
+      for (const RelativeSEMeasurement *m : mPoseGraph->activeLoopClosures()) {
+        weights_before[m] = m->weight;
+      }
       updateMeasurementWeights();
+      mLastWeightChange = 0;
+      for (const RelativeSEMeasurement *m : mPoseGraph->activeLoopClosures()) {
+        // Weights of shared loop closures with robots of smaller IDs are set by the neighbor
+        if (m->r1 != m->r2 && std::min(m->r1, m->r2) < getID()) continue;
+        const auto it = weights_before.find(m);
+        if (it != weights_before.end())
+          mLastWeightChange = std::max(mLastWeightChange, std::abs(m->weight - it->second));
+      }
+      mConvergencePredictor.reset();
+      mPredictorStartIteration = iteration_number();
+      if (mParamsROS.rejectOutliersAtWeightUpdate &&
+          mParams.robustCostParams.costType == RobustCostParameters::Type::GNC_TLS) {
+        const auto weight_stat = rejectConvergedOutliers(true);
+        if (weight_stat.num_rejected > 0) {
+          ROS_INFO("Robot %u rejected %zu loop closures during weight update.",
+                   getID(), weight_stat.num_rejected);
+          mDataMatricesStale = true;
+        }
+      }
+      if (mParamsROS.weightFixingPatience > 0 &&
+          mParams.robustCostParams.costType == RobustCostParameters::Type::GNC_TLS) {
+        size_t num_fixed = fixConvergedWeights();
+        if (num_fixed > 0) {
+          ROS_INFO("Robot %u fixed %zu converged loop closure weights.", getID(), num_fixed);
+          mDataMatricesStale = true;
+        }
+      }
       // Require latest iterations from all neighbor robots
       ROS_WARN("Require latest iteration %d from all neighbors.", iteration_number());
       for (const auto &neighbor : getNeighbors()) {
@@ -1252,6 +1991,28 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
   }
 }
 
+void PGOAgentROS::resumeOptimization(unsigned iteration) {
+  if (!isRobotActive(getID()) || mState != PGOAgentState::INITIALIZED) {
+    return;
+  }
+  mIterationNumber = iteration;
+  mSynchronousOptimizationRequested = false;
+  // Iteration numbers of neighbors may decrease after recovery
+  processPublicPosesMailbox();
+  mPublicPosesMailbox.assign(mParams.numRobots, PublicPosesMailboxSlot());
+  mAuxPublicPosesMailbox.assign(mParams.numRobots, PublicPosesMailboxSlot());
+  for (const auto &neighbor : getNeighbors()) {
+    mTeamIterRequired[neighbor] = iteration_number();
+    mTeamIterReceived[neighbor] = 0;  // Force robot to wait for updated public poses from neighbors
+  }
+  ROS_WARN("Robot %u reset iteration number to %u.", getID(), iteration_number());
+
+  if (isLeader()) {
+    ROS_WARN("Leader %u publishes update command.", getID());
+    publishUpdateCommand(getID());
+  }
+}
+
 void PGOAgentROS::publicPosesCallback(const PublicPosesConstPtr &msg) {
 
   // Discard message sent by robots in other clusters
@@ -1265,49 +2026,102 @@ void PGOAgentROS::publicPosesCallback(const PublicPosesConstPtr &msg) {
     return;
   }
 
-  // Generate a random permutation of indices
-  PoseDict poseDict;
-  for (size_t index = 0; index < msg->pose_ids.size(); ++index) {
-    const PoseID nID(msg->robot_id, msg->pose_ids.at(index));
-    const auto matrix = MatrixFromMsg(msg->poses.at(index));
-    poseDict.emplace(nID, matrix);
+  // Discard messages addressed to other robots
+  if (msg->destination_robot_id != getID()) {
+    return;
   }
-  if (!msg->is_auxiliary) {
-    updateNeighborPoses(msg->robot_id, poseDict);
-  } else {
-    updateAuxNeighborPoses(msg->robot_id, poseDict);
+
+  // Discard poses of a previous relaxation rank
+  if (!msg->poses.empty() && msg->poses[0].rows != r) {
+    return;
+  }
+
+  // Keep only the newest message; older messages are never deserialized
+  auto &slot = msg->is_auxiliary ? mAuxPublicPosesMailbox[msg->robot_id]
+                                 : mPublicPosesMailbox[msg->robot_id];
+  if (slot.msg) {
+    if (std::make_pair(msg->instance_number, msg->iteration_number) <
+        std::make_pair(slot.msg->instance_number, slot.msg->iteration_number)) {
+      mNumStalePublicPoses++;
+      return;
+    }
+    if (slot.pending) mNumStalePublicPoses++;
   }
+  slot.msg = msg;
+  slot.pending = true;
 
   // Update local bookkeeping
   mTeamIterReceived[msg->robot_id] = msg->iteration_number;
   mTotalBytesReceived += computePublicPosesMsgSize(*msg);
 }
 
+void PGOAgentROS::processPublicPosesMailbox() {
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    for (auto *slot : {&mPublicPosesMailbox[robot_id], &mAuxPublicPosesMailbox[robot_id]}) {
+      if (!slot->pending) continue;
+      slot->pending = false;
+      const auto &msg = slot->msg;
+      PoseDict poseDict;
+      for (size_t index = 0; index < msg->pose_ids.size(); ++index) {
+        const PoseID nID(msg->robot_id, msg->pose_ids.at(index));
+        const auto matrix = MatrixFromMsg(msg->poses.at(index));
+        poseDict.emplace(nID, matrix);
+      }
+      if (!msg->is_auxiliary) {
+        updateNeighborPoses(msg->robot_id, poseDict);
+      } else {
+        updateAuxNeighborPoses(msg->robot_id, poseDict);
+      }
+    }
+  }
+}
+
 void PGOAgentROS::publicMeasurementsCallback(const RelativeMeasurementListConstPtr &msg) {
   // Ignore if message not addressed to this robot
   if (msg->to_robot != getID()) {
     return;
   }
+  // The worker thread reads the pose graph during the local solve
+  if (deferCallback([this, msg]() { publicMeasurementsCallback(msg); }, true)) {
+    return;
+  }
   // Ignore if does not have local odometry
   if (mPoseGraph->numOdometry() == 0)
     return;
-  // Ignore if already received inter-robot loop closures from this robot
-  if (mTeamReceivedSharedLoopClosures[msg->from_robot])
-    return;
   // Ignore if from another cluster
   if (msg->from_cluster != getClusterID()) 
     return;
+  // If already received inter-robot loop closures from this robot, only loop closures
+  // added by the neighbor during optimization are new
+  if (mTeamReceivedSharedLoopClosures[msg->from_robot]) {
+    if (mParamsROS.onlinePoseGraphUpdate && mState == PGOAgentState::INITIALIZED) {
+      std::vector<RelativeSEMeasurement> measurements;
+      for (const auto &e : msg->edges) {
+        if (e.robot_from == (int) getID() || e.robot_to == (int) getID())
+          measurements.push_back(RelativeMeasurementFromMsg(e));
+      }
+      growPoseGraph(measurements);
+    }
+    return;
+  }
   mTeamReceivedSharedLoopClosures[msg->from_robot] = true;
 
   // Add inter-robot loop closures that involve this robot
   const auto num_before = mPoseGraph->numSharedLoopClosures();
   for (const auto &e : msg->edges) {
     if (e.robot_from == (int) getID() || e.robot_to == (int) getID()) {
-      const auto measurement = RelativeMeasurementFromMsg(e);
+      auto measurement = RelativeMeasurementFromMsg(e);
+      if (!internalMeasurement(measurement)) {
+        ROS_WARN("Robot %u ignores shared loop closure from robot %u on a reduced pose.",
+                 getID(), msg->from_robot);
+        continue;
+      }
       addMeasurement(measurement);
     }
   }
   const auto num_after = mPoseGraph->numSharedLoopClosures();
+  invalidatePublicPosesSendPlans();
+  mSentEdgeWeightTablesValid = false;
   ROS_INFO("Robot %u received measurements from %u: "
            "added %u missing measurements.", getID(), msg->from_robot, num_after - num_before);
 }
@@ -1315,18 +2129,58 @@ void PGOAgentROS::publicMeasurementsCallback(const RelativeMeasurementListConstP
 void PGOAgentROS::measurementWeightsCallback(const RelativeMeasurementWeightsConstPtr &msg) {
   // if (mState != PGOAgentState::INITIALIZED) return;
   if (msg->destination_robot_id != getID()) return;
+  // The worker thread reads the measurement weights during the local solve
+  if (deferCallback([this, msg]() { measurementWeightsCallback(msg); }, true)) return;
   if (msg->cluster_id != getClusterID()) return;
-  bool weights_updated = false;
-  for (size_t k = 0; k < msg->weights.size(); ++k) {
-    const unsigned robotSrc = msg->src_robot_ids[k];
-    const unsigned robotDst = msg->dst_robot_ids[k];
-    const unsigned poseSrc = msg->src_pose_ids[k];
-    const unsigned poseDst = msg->dst_pose_ids[k];
-    const PoseID srcID(robotSrc, poseSrc);
-    const PoseID dstID(robotDst, poseDst);
-    double w = msg->weights[k];
-    bool fixed = msg->fixed_weights[k];
+  auto &table = mReceivedEdgeWeightTables[msg->robot_id];
+  const bool full_table = msg->base_version == 0;
+  if (full_table) {
+    // A full table (re)defines the indices used by subsequent messages
+    if (msg->src_robot_ids.size() != msg->table_size || msg->weights.size() != msg->table_size) {
+      ROS_ERROR("Received malformed weight table from robot %u.", msg->robot_id);
+      return;
+    }
+    table.edges.clear();
+    for (size_t k = 0; k < msg->table_size; ++k) {
+      PoseID src_id(msg->src_robot_ids[k], msg->src_pose_ids[k]);
+      PoseID dst_id(msg->dst_robot_ids[k], msg->dst_pose_ids[k]);
+      // Local poses not in the optimized pose graph get an invalid index
+      const unsigned invalid_index = std::numeric_limits<unsigned>::max();
+      if (src_id.robot_id == getID() && !internalPoseIndex(src_id.frame_id, src_id.frame_id))
+        src_id.frame_id = invalid_index;
+      if (dst_id.robot_id == getID() && !internalPoseIndex(dst_id.frame_id, dst_id.frame_id))
+        dst_id.frame_id = invalid_index;
+      table.edges.emplace_back(src_id, dst_id);
+    }
+    // Force the full table to be applied
+    table.weights.assign(msg->table_size, -1);
+    table.fixed_weights.assign(msg->table_size, false);
+    table.full_table_requested = false;
+  } else if (msg->base_version != table.version || msg->table_size != table.edges.size()) {
+    ROS_WARN_THROTTLE(1, "Missed weight update from robot %u (local version %u, received base %u). "
+                      "Request full table.", msg->robot_id, table.version, msg->base_version);
+    // Requested in the following statuses until the full table arrives
+    table.full_table_requested = true;
+    return;
+  }
 
+  for (size_t k = 0; k < msg->weights.size(); ++k) {
+    const size_t index = full_table ? k : msg->edge_indices[k];
+    if (index >= table.edges.size()) {
+      ROS_ERROR("Received weight for invalid edge index %zu.", index);
+      continue;
+    }
+    const float w = msg->weights[k];
+    const bool fixed = msg->fixed_weights[k];
+    // Skip weights that did not change since the last message
+    if (w == table.weights[index] && fixed == table.fixed_weights[index]) continue;
+    table.weights[index] = w;
+    table.fixed_weights[index] = fixed;
+
+    const PoseID &srcID = table.edges[index].src_pose_id;
+    const PoseID &dstID = table.edges[index].dst_pose_id;
+    const unsigned robotSrc = srcID.robot_id;
+    const unsigned robotDst = dstID.robot_id;
     unsigned otherID;
     if (robotSrc == getID() && robotDst != getID()) {
       otherID = robotDst;
@@ -1338,18 +2192,17 @@ void PGOAgentROS::measurementWeightsCallback(const RelativeMeasurementWeightsCon
     }
     if (!isRobotActive(otherID)) continue;
     if (otherID < getID()) {
-      if (setMeasurementWeight(srcID, dstID, w, fixed))
-        weights_updated = true;
-      else {
+      if (setMeasurementWeight(srcID, dstID, w, fixed)) {
+        mDataMatricesStale = true;
+        // Stop sending poses that are only used by rejected loop closures
+        if (fixed && w == 0) invalidatePublicPosesSendPlans();
+      } else {
         ROS_WARN("Cannot find specified shared loop closure (%u, %u) -> (%u, %u)",
-                  robotSrc, poseSrc, robotDst, poseDst);
+                  robotSrc, srcID.frame_id, robotDst, dstID.frame_id);
       }
     }
   }
-  if (weights_updated) {
-    // Need to recompute data matrices in the pose graph
-    mPoseGraph->clearDataMatrices();
-  }
+  table.version = msg->version;
 }
 
 void PGOAgentROS::timerCallback(const ros::TimerEvent &event) {
@@ -1365,43 +2218,158 @@ void PGOAgentROS::timerCallback(const ros::TimerEvent &event) {
     // Update leader robot when idle
     updateCluster();
     // Initialize a new round of dpgo
-    int elapsed_sec = (ros::Time::now() - mLastResetTime).toSec();
-    if (isLeader() && elapsed_sec > 10) {
+    double elapsed_sec = (ros::Time::now() - mLastResetTime).toSec();
+    if (isLeader() && !roundPoseGraphQueryPending() && (mRankIncreasePending || roundTriggered(elapsed_sec))) {
       publishRequestPoseGraphCommand();
     }
   }
-  if (mState == PGOAgentState::INITIALIZED) {
+  // The worker thread owns the iterate during the local solve
+  if (mState == PGOAgentState::INITIALIZED && !mLocalSolve.valid()) {
     publishPublicPoses(false);
     if (mParamsROS.acceleration)
       publishPublicPoses(true);
-    publishMeasurementWeights();
+    // Only send changed weights, except for a periodic full table that
+    // allows receivers to recover from lost messages
+    mWeightTablePublishCount = (mWeightTablePublishCount + 1) % 10;
+    publishMeasurementWeights(mWeightTablePublishCount == 0);
     if (isLeader()) {
       publishAnchor();
-      publishActiveRobotsCommand();
     }
   }
+  if (mState == PGOAgentState::INITIALIZED && isLeader()) {
+    publishActiveRobotsCommand();
+  }
   publishStatus();
 }
 
+void PGOAgentROS::heartbeatTimerCallback(const ros::TimerEvent &event) {
+  // Runs on the heartbeat thread
+  publishNoopCommand();
+}
+
 void PGOAgentROS::visualizationTimerCallback(const ros::TimerEvent &event) {
   publishOptimizedTrajectory();
   publishLoopClosureMarkers();
 }
 
+void PGOAgentROS::poseGraphSummaryTimerCallback(const ros::TimerEvent &event) {
+  if (mState != PGOAgentState::WAIT_FOR_DATA) return;
+  startPoseGraphQuery(PoseGraphQuery::Purpose::Summary);
+}
+
+bool PGOAgentROS::roundTriggered(double elapsed_sec) {
+  if (elapsed_sec <= mParamsROS.minRoundInterval) return false;
+  if (!mParamsROS.changeTriggeredRounds) return true;
+  if (elapsed_sec > mParamsROS.maxRoundInterval) {
+    ROS_INFO("Robot %u starts new round after %.1f sec.", getID(), elapsed_sec);
+    return true;
+  }
+  unsigned num_new_loop_closures = 0;
+  if (mLatestPoseGraphSummary.numLoopClosures > mRoundPoseGraphSummary.numLoopClosures)
+    num_new_loop_closures = mLatestPoseGraphSummary.numLoopClosures - mRoundPoseGraphSummary.numLoopClosures;
+  for (const auto &it : mTeamStatusMsg) {
+    if (it.first == getID() || it.second.cluster_id != getClusterID()) continue;
+    num_new_loop_closures += it.second.num_new_loop_closures;
+  }
+  if ((int) num_new_loop_closures < mParamsROS.roundTriggerLoopClosures) return false;
+  ROS_INFO("Robot %u starts new round with %u new loop closures.", getID(), num_new_loop_closures);
+  return true;
+}
+
+void PGOAgentROS::onlineUpdateTimerCallback(const ros::TimerEvent &event) {
+  if (mState != PGOAgentState::INITIALIZED || !isRobotActive(getID())) return;
+  startPoseGraphQuery(PoseGraphQuery::Purpose::OnlineUpdate);
+}
+
+void PGOAgentROS::updatePoseGraphOnline(const pose_graph_tools::PoseGraph &pose_graph) {
+  if (mState != PGOAgentState::INITIALIZED || !isRobotActive(getID())) return;
+  // The worker thread reads the pose graph during the local solve
+  if (deferCallback([this, pose_graph]() { updatePoseGraphOnline(pose_graph); }, true)) return;
+  const auto shared_loop_closures = growPoseGraph(RelativeMeasurementsFromMsg(pose_graph.edges));
+  // Neighbors need the new shared loop closures in their pose graphs
+  if (!shared_loop_closures.empty()) {
+    publishPublicMeasurements(shared_loop_closures);
+  }
+}
+
+std::vector<RelativeSEMeasurement> PGOAgentROS::growPoseGraph(
+    const std::vector<RelativeSEMeasurement> &measurements) {
+  std::vector<RelativeSEMeasurement> added_shared_loop_closures;
+  const unsigned num_poses_before = num_poses();
+  const unsigned num_measurements_before = mPoseGraph->numMeasurements();
+  std::lock_guard<std::mutex> measurements_lock(mMeasurementsMutex);
+  std::lock_guard<std::mutex> poses_lock(mPosesMutex);
+
+  // Private measurements define the new poses of this robot
+  std::vector<RelativeSEMeasurement> shared_loop_closures;
+  shared_loop_closures.swap(mPendingSharedLoopClosures);
+  for (const auto &m : measurements) {
+    if (m.r1 != getID() && m.r2 != getID()) {
+      ROS_ERROR("Robot %u received irrelevant measurement! ", getID());
+      continue;
+    }
+    if (mPoseGraph->hasMeasurement(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2))) continue;
+    if (m.r1 != m.r2) {
+      shared_loop_closures.push_back(m);
+    } else {
+      mPoseGraph->addMeasurement(m);
+    }
+  }
+  const unsigned num_poses_after = mPoseGraph->n();
+
+  // Shared loop closures can only be added once the local pose exists
+  for (const auto &m : shared_loop_closures) {
+    const size_t local_index = m.r1 == getID() ? m.p1 : m.p2;
+    if (local_index >= num_poses_after) {
+      mPendingSharedLoopClosures.push_back(m);
+    } else if (!mPoseGraph->hasMeasurement(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2))) {
+      mPoseGraph->addMeasurement(m);
+      added_shared_loop_closures.push_back(m);
+    }
+  }
+  if (mPoseGraph->numMeasurements() == num_measurements_before) {
+    return added_shared_loop_closures;
+  }
+
+  // Initialize new poses from the current iterate by odometry
+  if (num_poses_after > num_poses_before) {
+    const auto &odometry = mPoseGraph->odometry();
+    extendTrajectoryByOdometry(X, num_poses_after, odometry);
+    extendTrajectoryByOdometry(XPrev, num_poses_after, odometry);
+    if (mParams.acceleration) {
+      extendTrajectoryByOdometry(Y, num_poses_after, odometry);
+      extendTrajectoryByOdometry(V, num_poses_after, odometry);
+    }
+    n = num_poses_after;
+  }
+  mPoseGraph->clearDataMatrices();
+  invalidatePublicPosesSendPlans();
+  mSentEdgeWeightTablesValid = false;
+  ROS_INFO("Robot %u added %u poses and %u measurements during optimization (%zu pending).",
+           getID(), num_poses_after - num_poses_before,
+           mPoseGraph->numMeasurements() - num_measurements_before,
+           mPendingSharedLoopClosures.size());
+  return added_shared_loop_closures;
+}
+
 void PGOAgentROS::storeActiveNeighborPoses() {
   Matrix matrix;
   int num_poses_stored = 0;
+  const unsigned round = instance_number();
   for (const auto &nbr_pose_id : mPoseGraph->activeNeighborPublicPoseIDs()) {
     if (getNeighborPoseInGlobalFrame(nbr_pose_id.robot_id, 
                                      nbr_pose_id.frame_id,
                                      matrix)) {
-      Pose T(dimension());
-      T.setData(matrix);
-      mCachedNeighborPoses[nbr_pose_id] = T;
-      num_poses_stored++;
+      if (mCachedNeighborPoses.insert(nbr_pose_id, matrix, round))
+        num_poses_stored++;
     }
   }
-  ROS_INFO("Stored %i neighbor poses in world frame.", num_poses_stored);
+  size_t num_robots_evicted = 0;
+  if (mParamsROS.neighborCacheEvictionRounds > 0) {
+    num_robots_evicted = mCachedNeighborPoses.evictIdleRobots(round, mParamsROS.neighborCacheEvictionRounds);
+  }
+  ROS_INFO("Stored %i neighbor poses in world frame (cached %zu poses, %zu bytes, evicted %zu robots).",
+           num_poses_stored, mCachedNeighborPoses.size(), mCachedNeighborPoses.memoryUsage(), num_robots_evicted);
 }
 
 void PGOAgentROS::setInactiveNeighborPoses() {
@@ -1410,51 +2378,318 @@ void PGOAgentROS::setInactiveNeighborPoses() {
     return;
   }
   int num_poses_initialized = 0;
-  for (const auto &it : mCachedNeighborPoses) {
-    const auto &pose_id = it.first;
+  mCachedNeighborPoses.forEach([&](const PoseID &pose_id, const Eigen::Map<const Matrix> &Ti) {
     // Active neighbors will transmit their poses
     // Therefore we only use stored poses for inactive neighbors
     if (!isRobotActive(pose_id.robot_id)) {
-      const auto &Ti = it.second;
-      Matrix Xi_mat = YLift.value() * Ti.getData();
+      Matrix Xi_mat = YLift.value() * Ti;
       LiftedPose Xi(r, d);
       Xi.setData(Xi_mat);
       neighborPoseDict[pose_id] = Xi;
       num_poses_initialized++;
     }
-  }
+  });
   ROS_INFO("Set %i inactive neighbor poses.", num_poses_initialized);
 }
 
 void PGOAgentROS::storeActiveEdgeWeights() {
   int num_edges_stored = 0;
+  const unsigned round = instance_number();
   for (const RelativeSEMeasurement *m: mPoseGraph->activeLoopClosures()) {
-    const PoseID src_id(m->r1, m->p1);
-    const PoseID dst_id(m->r2, m->p2);
-    const EdgeID edge_id(src_id, dst_id);
+    // Cache with full pose indices, which do not change when the reduced graph is rebuilt
+    const RelativeSEMeasurement external_m = externalMeasurement(*m);
+    const EdgeID edge_id(PoseID(external_m.r1, external_m.p1), PoseID(external_m.r2, external_m.p2));
     if (edge_id.isSharedLoopClosure()) {
-      mCachedEdgeWeights[edge_id] = m->weight;
-      num_edges_stored++;
+      if (mCachedEdgeWeights.insert(edge_id, m->weight, round))
+        num_edges_stored++;
     }
   }
-  ROS_INFO("Stored %i active edge weights.", num_edges_stored);
+  size_t num_robots_evicted = 0;
+  if (mParamsROS.neighborCacheEvictionRounds > 0) {
+    num_robots_evicted = mCachedEdgeWeights.evictIdleRobots(round, mParamsROS.neighborCacheEvictionRounds);
+  }
+  ROS_INFO("Stored %i active edge weights (cached %zu weights, %zu bytes, evicted %zu robots).",
+           num_edges_stored, mCachedEdgeWeights.size(), mCachedEdgeWeights.memoryUsage(), num_robots_evicted);
 }
 
 void PGOAgentROS::setInactiveEdgeWeights() {
   int num_edges_set = 0;
   for (RelativeSEMeasurement *m: mPoseGraph->inactiveLoopClosures()) {
-    const PoseID src_id(m->r1, m->p1);
-    const PoseID dst_id(m->r2, m->p2);
-    const EdgeID edge_id(src_id, dst_id);
-    const auto &it = mCachedEdgeWeights.find(edge_id);
-    if (it != mCachedEdgeWeights.end()) {
-      m->weight = it->second;
+    const RelativeSEMeasurement external_m = externalMeasurement(*m);
+    const EdgeID edge_id(PoseID(external_m.r1, external_m.p1), PoseID(external_m.r2, external_m.p2));
+    double weight;
+    if (mCachedEdgeWeights.find(edge_id, weight)) {
+      m->weight = weight;
       num_edges_set++;
     } 
   }
   ROS_INFO("Set %i inactive edge weights.", num_edges_set);
 }
 
+LoopClosureWeightStatistics PGOAgentROS::rejectConvergedOutliers(bool responsible_only) {
+  const std::vector<RelativeSEMeasurement *> loop_closures = mPoseGraph->activeLoopClosures();
+  const double threshold = mParamsROS.weightConvergenceThreshold;
+  // Residuals are evaluated in parallel. computeMeasurementResidual is const and only reads
+  // the iterate and the neighbor poses, so the measurements are left untouched until all
+  // residuals are evaluated, and rejected loop closures are marked in a separate buffer.
+  std::vector<char> rejected(loop_closures.size(), 0);
+  const LoopClosureWeightStatistics stat = tbb::parallel_reduce(
+      tbb::blocked_range<size_t>(0, loop_closures.size()),
+      LoopClosureWeightStatistics(),
+      [&](const tbb::blocked_range<size_t> &range, LoopClosureWeightStatistics stat) {
+        double residual = 0;
+        for (size_t k = range.begin(); k != range.end(); ++k) {
+          const RelativeSEMeasurement *m = loop_closures[k];
+          if (m->fixedWeight) continue;
+          // Weights of shared loop closures with robots of smaller IDs are set by the neighbor
+          if (responsible_only && m->r1 != m->r2 && std::min(m->r1, m->r2) < getID()) continue;
+          if (!computeMeasurementResidual(*m, &residual)) continue;
+          stat.num_evaluated++;
+          stat.max_residual = std::max(stat.max_residual, residual);
+          if (mRobustCost.weight(residual) < threshold) {
+            rejected[k] = 1;
+            stat.num_rejected++;
+          }
+        }
+        return stat;
+      },
+      [](LoopClosureWeightStatistics a, const LoopClosureWeightStatistics &b) {
+        a += b;
+        return a;
+      });
+  for (size_t k = 0; k < loop_closures.size(); ++k) {
+    if (!rejected[k]) continue;
+    loop_closures[k]->weight = 0;
+    loop_closures[k]->fixedWeight = true;
+  }
+  return stat;
+}
+
+void PGOAgentROS::saveCheckpoint() {
+  if (mParamsROS.checkpointPath.empty()) return;
+  if (mCheckpointWriter.valid() &&
+      mCheckpointWriter.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    ROS_WARN("Robot %u is still writing the previous checkpoint. Skip checkpoint.", getID());
+    return;
+  }
+
+  // Copy the state here so that the writer does not race with the next round
+  auto checkpoint = std::make_shared<AgentCheckpoint>();
+  checkpoint->robot_id = getID();
+  checkpoint->d = d;
+  checkpoint->r = r;
+  checkpoint->poses = mCachedPoses;
+  mCachedNeighborPoses.forEach([&](const PoseID &pose_id, const Eigen::Map<const Matrix> &T) {
+    Pose pose(d);
+    pose.setData(T);
+    checkpoint->neighbor_poses.emplace(pose_id, pose);
+  });
+  mCachedEdgeWeights.forEach([&](const EdgeID &edge_id, double weight) {
+    checkpoint->edge_weights.emplace(edge_id, weight);
+  });
+  checkpoint->lifting_matrix = YLift;
+  // Measurements are saved with full pose indices so that they can be matched after reduction
+  for (const auto &m : mPoseGraph->allMeasurements()) {
+    checkpoint->measurements.push_back(externalMeasurement(m));
+  }
+
+  const std::string path = mParamsROS.checkpointPath;
+  const unsigned robot_id = getID();
+  mCheckpointWriter = std::async(std::launch::async, [path, robot_id, checkpoint]() {
+    if (writeCheckpoint(path, *checkpoint)) {
+      ROS_INFO("Robot %u saved checkpoint to %s.", robot_id, path.c_str());
+    } else {
+      ROS_WARN("Robot %u failed to save checkpoint to %s.", robot_id, path.c_str());
+    }
+  });
+}
+
+bool PGOAgentROS::loadCheckpoint() {
+  AgentCheckpoint checkpoint;
+  if (!readCheckpoint(mParamsROS.checkpointPath, checkpoint)) {
+    ROS_WARN("Robot %u cannot read checkpoint from %s. Start without checkpoint.",
+             getID(), mParamsROS.checkpointPath.c_str());
+    return false;
+  }
+  // With adaptive relaxation rank, restart from the rank of the checkpoint
+  const bool rank_matches = mParamsROS.adaptiveRelaxationRank ?
+                            (checkpoint.r > d && checkpoint.r <= mParams.r) : checkpoint.r == r;
+  if (checkpoint.robot_id != getID() || checkpoint.d != d || !rank_matches) {
+    ROS_ERROR("Robot %u checkpoint does not match (robot %u, d=%u, r=%u). Start without checkpoint.",
+              getID(), checkpoint.robot_id, checkpoint.d, checkpoint.r);
+    return false;
+  }
+
+  if (mParamsROS.adaptiveRelaxationRank) setRelaxationRank(checkpoint.r);
+  mCachedPoses = checkpoint.poses;
+  mCachedNeighborPoses.clear();
+  for (const auto &it : checkpoint.neighbor_poses)
+    mCachedNeighborPoses.insert(it.first, it.second.getData(), instance_number());
+  mCachedEdgeWeights.clear();
+  for (const auto &it : checkpoint.edge_weights)
+    mCachedEdgeWeights.insert(it.first, it.second, instance_number());
+  if (checkpoint.lifting_matrix) setLiftingMatrix(checkpoint.lifting_matrix.value());
+  // Restored measurements keep their weights, which seeds the next round
+  for (const auto &m : checkpoint.measurements) {
+    RelativeSEMeasurement internal_m = m;
+    if (!internalMeasurement(internal_m)) continue;
+    if (!mPoseGraph->hasMeasurement(PoseID(internal_m.r1, internal_m.p1), PoseID(internal_m.r2, internal_m.p2))) {
+      addMeasurement(internal_m);
+    }
+  }
+  // The reduced pose graph is rebuilt from the front end, so the weights are applied again then
+  mCheckpointMeasurements = checkpoint.measurements;
+  invalidatePublicPosesSendPlans();
+  mSentEdgeWeightTablesValid = false;
+  mWarmStartPending = true;
+  ROS_INFO("Robot %u loaded checkpoint (%zu measurements, %zu neighbor poses, %zu edge weights).",
+           getID(), checkpoint.measurements.size(), mCachedNeighborPoses.size(), mCachedEdgeWeights.size());
+  return true;
+}
+
+void PGOAgentROS::applyCheckpointWeights() {
+  size_t num_weights_applied = 0;
+  for (const auto &m : mCheckpointMeasurements) {
+    RelativeSEMeasurement internal_m = m;
+    if (!internalMeasurement(internal_m)) continue;
+    RelativeSEMeasurement *edge = mPoseGraph->findMeasurement(PoseID(internal_m.r1, internal_m.p1),
+                                                              PoseID(internal_m.r2, internal_m.p2));
+    if (edge && !edge->fixedWeight) {
+      edge->weight = m.weight;
+      edge->fixedWeight = m.fixedWeight;
+      num_weights_applied++;
+    }
+  }
+  ROS_INFO("Robot %u applied %zu checkpoint weights.", getID(), num_weights_applied);
+  mCheckpointMeasurements.clear();
+}
+
+size_t PGOAgentROS::fixConvergedWeights() {
+  const double threshold = mParamsROS.weightConvergenceThreshold;
+  size_t num_fixed = 0;
+  bool shared_rejected = false;
+  for (RelativeSEMeasurement *m : mPoseGraph->activeLoopClosures()) {
+    if (m->fixedWeight) continue;
+    // Weights of shared loop closures with robots of smaller IDs are set by the neighbor
+    if (m->r1 != m->r2 && std::min(m->r1, m->r2) < getID()) continue;
+    const EdgeID edge_id(PoseID(m->r1, m->p1), PoseID(m->r2, m->p2));
+    int &count = mWeightConvergenceCounts[edge_id];
+    if (m->weight < threshold) {
+      count = std::min(count, 0) - 1;
+    } else if (m->weight > 1 - threshold) {
+      count = std::max(count, 0) + 1;
+    } else {
+      count = 0;
+    }
+    if (std::abs(count) >= mParamsROS.weightFixingPatience) {
+      m->weight = count > 0 ? 1 : 0;
+      m->fixedWeight = true;
+      if (m->weight == 0 && edge_id.isSharedLoopClosure()) shared_rejected = true;
+      mWeightConvergenceCounts.erase(edge_id);
+      num_fixed++;
+    }
+  }
+  // Shared poses whose only loop closures are rejected are no longer transmitted
+  if (shared_rejected) invalidatePublicPosesSendPlans();
+  return num_fixed;
+}
+
+double PGOAgentROS::globalGradNorm() const {
+  if (mLastOptimizedIteration == 0) return std::numeric_limits<double>::infinity();
+  double squared_gradnorm = mLocalOptResult.gradNormOpt * mLocalOptResult.gradNormOpt;
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    if (robot_id == getID() || !isRobotActive(robot_id)) continue;
+    const auto &it = mTeamStatusMsg.find(robot_id);
+    if (it == mTeamStatusMsg.end() || it->second.optimized_iteration == 0)
+      return std::numeric_limits<double>::infinity();
+    squared_gradnorm += it->second.gradnorm * it->second.gradnorm;
+  }
+  return std::sqrt(squared_gradnorm);
+}
+
+bool PGOAgentROS::predictedConvergence() const {
+  if (mConvergencePredictor.converged(mParamsROS.predictedDecreaseTolerance)) {
+    ROS_INFO("Predicted remaining cost decrease %.2e (total decrease %.2e).",
+             mConvergencePredictor.predictedRemainingDecrease(),
+             mConvergencePredictor.totalDecrease());
+    return true;
+  }
+  if (mParamsROS.globalGradNormTolerance > 0) {
+    const double gradnorm = globalGradNorm();
+    if (gradnorm < mParamsROS.globalGradNormTolerance) {
+      ROS_INFO("Global gradnorm %.2e below tolerance.", gradnorm);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PGOAgentROS::teamWeightsSettled() const {
+  if (mWeightUpdateCount == 0) return false;
+  const double threshold = mParamsROS.weightConvergenceThreshold;
+  if (mLastWeightChange >= threshold) return false;
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    if (robot_id == getID() || !isRobotActive(robot_id)) continue;
+    const auto &it = mTeamStatusMsg.find(robot_id);
+    if (it == mTeamStatusMsg.end() || it->second.weight_change >= threshold) return false;
+  }
+  return true;
+}
+
+void PGOAgentROS::setRelaxationRank(unsigned rank) {
+  if (rank == r) return;
+  if (rank < d || rank > mParams.r) {
+    ROS_ERROR("Robot %u cannot set relaxation rank %u (d=%u, max rank %u).", getID(), rank, d, mParams.r);
+    return;
+  }
+  if (mState != PGOAgentState::WAIT_FOR_DATA) {
+    ROS_WARN("Robot %u cannot change relaxation rank during optimization. Reset...", getID());
+    reset();
+  }
+  ROS_INFO("Robot %u changes relaxation rank from %u to %u.", getID(), r, rank);
+  r = rank;
+  {
+    // The pose graph stores lifted neighbor poses of the previous rank
+    std::lock_guard<std::mutex> lock(mMeasurementsMutex);
+    const auto measurements = mPoseGraph->allMeasurements();
+    mPoseGraph = std::make_shared<PoseGraph>(mID, r, d);
+    for (const auto &m : measurements) mPoseGraph->addMeasurement(m);
+  }
+  neighborPoseDict.clear();
+  neighborAuxPoseDict.clear();
+  globalAnchor.reset();
+  // The lifting matrix is generated deterministically for each rank, so robots
+  // that already had one regenerate it, and the others receive it from the leader
+  const bool had_lifting_matrix = YLift.has_value();
+  YLift.reset();
+  if (had_lifting_matrix) setLiftingMatrix(fixedStiefelVariable(d, r));
+  invalidatePublicPosesSendPlans();
+  mSentEdgeWeightTablesValid = false;
+}
+
+bool PGOAgentROS::relaxationRankIncreaseRequired() {
+  if (!mParamsROS.adaptiveRelaxationRank || r >= mParams.r) return false;
+  Matrix gram = liftedRotationGram(X);
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    if (robot_id == getID() || !isRobotActive(robot_id)) continue;
+    const auto &it = mTeamStatusMsg.find(robot_id);
+    if (it == mTeamStatusMsg.end() || it->second.lifted_gram.size() != (size_t) gram.size()) {
+      ROS_WARN("Robot %u lifted rotations unavailable. Keep relaxation rank %u.", robot_id, r);
+      return false;
+    }
+    gram += Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(
+        it->second.lifted_gram.data(), r, r);
+  }
+  const double ratio = liftedRankRatio(gram, d);
+  if (ratio < mParamsROS.rankDeficiencyTolerance) {
+    ROS_INFO("Robot %u: solution at relaxation rank %u is rank deficient (ratio %.1e).", getID(), r, ratio);
+    return false;
+  }
+  ROS_INFO("Robot %u: solution at relaxation rank %u has full rank (ratio %.1e). Increase rank to %u.",
+           getID(), r, ratio, r + 1);
+  return true;
+}
+
 void PGOAgentROS::initializeGlobalAnchor() {
   if (!YLift) {
     ROS_WARN("Missing lifting matrix! Cannot initialize global anchor.");
@@ -1482,7 +2717,96 @@ void PGOAgentROS::updateCluster() {
       break;
     }
   }
-  ROS_INFO("Robot %u joins cluster %u.", getID(), mClusterID);
+  ROS_INFO("Robot %u joins cluster %u.", getID(), getClusterID());
+}
+
+unsigned PGOAgentROS::leaderSuccessor() const {
+  // Every robot in the cluster knows the active robots from SET_ACTIVE_ROBOTS,
+  // so all of them agree on the successor without further communication
+  return dpgo_ros::leaderSuccessor(getClusterID(), activeRobotFlags());
+}
+
+std::vector<bool> PGOAgentROS::activeRobotFlags() const {
+  std::vector<bool> active_robots(mParams.numRobots);
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    active_robots[robot_id] = isRobotActive(robot_id);
+  }
+  return active_robots;
+}
+
+bool PGOAgentROS::tracksLeaderState() const {
+  return isLeader() || (mParamsROS.leaderFailover && leaderSuccessor() == getID());
+}
+
+void PGOAgentROS::handleLeaderFailure() {
+  if (mParamsROS.leaderFailover) {
+    const unsigned successor = leaderSuccessor();
+    if (successor == getID()) {
+      takeOverLeadership();
+      return;
+    }
+    if (successor < mParams.numRobots && isRobotConnected(successor)) {
+      ROS_WARN_THROTTLE(1, "Robot %u waits for robot %u to take over from leader %u.",
+                        getID(), successor, getClusterID());
+      return;
+    }
+  }
+  ROS_WARN("Robot %u disconnected from leader %u... reset.", getID(), getClusterID());
+  reset();
+}
+
+void PGOAgentROS::takeOverLeadership() {
+  const unsigned failed_leader = getClusterID();
+  ROS_WARN("Robot %u takes over from failed leader %u at iteration %u.",
+           getID(), failed_leader, iteration_number());
+  logString("TAKEOVER");
+  mFailedLeaderID = failed_leader;
+  setRobotActive(failed_leader, false);
+  mClusterID = getID();
+  if (numActiveRobots() <= 1) {
+    ROS_WARN("Not enough active robots to resume... reset.");
+    reset();
+    return;
+  }
+
+  // The other robots follow once they receive the command. The iteration counters,
+  // GNC counters, anchor and lifting matrix are already replicated on every robot.
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::TAKEOVER;
+  msg->executing_iteration = iteration_number();
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    if (isRobotActive(robot_id)) {
+      msg->active_robots.push_back(robot_id);
+    }
+  }
+  publishAcknowledgedCommand(msg);
+  publishAnchor();
+  mLastCommandTime = ros::Time::now();
+}
+
+bool PGOAgentROS::acceptLeaderTakeover(const CommandConstPtr &msg) {
+  const unsigned new_leader = msg->publishing_robot;
+  // Own command, or retransmission after the takeover
+  if (new_leader == getClusterID()) {
+    return true;
+  }
+  const unsigned failed_leader = getClusterID();
+  unsigned leader_id = failed_leader;
+  std::vector<bool> active_robots = activeRobotFlags();
+  if (!mParamsROS.leaderFailover ||
+      !followLeaderTakeover(new_leader, msg->cluster_id, leader_id, active_robots)) {
+    ROS_WARN("Ignore TAKEOVER command from robot %u (leader %u).", new_leader, failed_leader);
+    return false;
+  }
+  ROS_WARN("Robot %u follows robot %u, which takes over from leader %u.",
+           getID(), new_leader, failed_leader);
+  mFailedLeaderID = failed_leader;
+  setRobotActive(failed_leader, false);
+  mClusterID = leader_id;
+  return true;
 }
 
 unsigned PGOAgentROS::getRobotClusterID(unsigned robot_id) const {
@@ -1512,11 +2836,55 @@ void PGOAgentROS::resetRobotClusterIDs() {
   }
 }
 
+void PGOAgentROS::resumeAfterTimeout() {
+  // The round may have ended while the robots received the active robots
+  if (!isLeader() || mState != PGOAgentState::INITIALIZED) return;
+  ROS_WARN("Number of active robots: %zu.", numActiveRobots());
+  if (numActiveRobots() > 1) {
+    if (mParamsROS.enableRecovery) {
+      // ROS_WARN("Attempt to resume optimization with %zu robots.", numActiveRobots());
+      publishRecoverCommand();
+    } else {
+      // ROS_WARN("Terminate with %zu robots.", numActiveRobots());
+      publishHardTerminateCommand();
+    }
+  } else {
+    // ROS_WARN("Terminate... Not enough active robots.");
+    publishHardTerminateCommand();
+  }
+}
+
 void PGOAgentROS::checkTimeout() {
   if (mParams.asynchronous) {
     return;
   }
 
+  // Messages that arrived while this thread was blocked, e.g., by a local solve, are delivered
+  // with the next spin. Suspect robots only once their arrival times have been recorded.
+  const ros::Time now = ros::Time::now();
+  const bool stalled = (now - mLastTimeoutCheckTime).toSec() > mParamsROS.heartbeatPeriod;
+  mLastTimeoutCheckTime = now;
+
+  // Handle robots suspected by the failure detector right away
+  if ((mParamsROS.adaptiveFailureDetection || mParamsROS.leaderFailover) && !stalled &&
+      mState == PGOAgentState::INITIALIZED && iteration_number() > 0) {
+    if (isLeader()) {
+      if (mParamsROS.adaptiveFailureDetection && checkDisconnectedRobot()) {
+        publishActiveRobotsCommand();
+        ROS_WARN("Number of active robots: %zu.", numActiveRobots());
+        // The failed robot may have been selected to update, so resume from the leader
+        if (numActiveRobots() > 1 && mParamsROS.enableRecovery) {
+          publishRecoverCommand();
+        } else {
+          publishHardTerminateCommand();
+        }
+        mLastCommandTime = ros::Time::now();
+      }
+    } else if (!isRobotConnected(getClusterID())) {
+      handleLeaderFailure();
+    }
+  }
+
   // Timeout if command channel quiet for long time 
   // This usually happen when robots get disconnected 
   double elapsedSecond = (ros::Time::now() - mLastCommandTime).toSec();
@@ -1527,25 +2895,15 @@ void PGOAgentROS::checkTimeout() {
       if (isLeader()) {
         if (checkDisconnectedRobot()) {
           publishActiveRobotsCommand();
-          ros::Duration(3).sleep();
-        }
-        ROS_WARN("Number of active robots: %zu.", numActiveRobots());
-        if (numActiveRobots() > 1) {
-          if (mParamsROS.enableRecovery) {
-            // ROS_WARN("Attempt to resume optimization with %zu robots.", numActiveRobots());
-            publishRecoverCommand();
-          } else {
-            // ROS_WARN("Terminate with %zu robots.", numActiveRobots());
-            publishHardTerminateCommand();
-          }
+          // Give the robots time to receive the active robots before resuming
+          mResumeTimer = nh.createTimer(ros::Duration(3),
+                                        [this](const ros::TimerEvent &event) { resumeAfterTimeout(); }, true);
         } else {
-          // ROS_WARN("Terminate... Not enough active robots.");
-          publishHardTerminateCommand();
+          resumeAfterTimeout();
         }
       } else {
         if (!isRobotConnected(getClusterID())) {
-          ROS_WARN("Disconnected from current cluster... reset.");
-          reset();
+          handleLeaderFailure();
         }
       }
     } else {
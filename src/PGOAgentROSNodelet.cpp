@@ -0,0 +1,45 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/PGOAgentROS.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <memory>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Nodelet that runs a single PGO agent. Agents loaded into the same nodelet manager
+ * exchange messages by pointer instead of serializing them over loopback TCP.
+ */
+class PGOAgentROSNodelet : public nodelet::Nodelet {
+ private:
+  std::unique_ptr<PGOAgentROS> mAgent;
+  ros::Timer mTimer;
+
+  void onInit() override {
+    unsigned ID = 0;
+    const auto params = loadPGOAgentROSParameters(getPrivateNodeHandle(), ID);
+    if (!params) {
+      NODELET_ERROR("Failed to load parameters of PGO agent.");
+      return;
+    }
+    // Callbacks of getNodeHandle() run on a single-threaded queue, same as in dpgo_ros_node
+    mAgent = std::make_unique<PGOAgentROS>(getNodeHandle(), getPrivateNodeHandle(), ID, params.value());
+    // Replace the 100 Hz main loop of dpgo_ros_node
+    mTimer = getNodeHandle().createTimer(ros::Duration(0.01), &PGOAgentROSNodelet::timerCallback, this);
+  }
+
+  void timerCallback(const ros::TimerEvent &event) {
+    mAgent->runOnce();
+  }
+};
+
+}  // namespace dpgo_ros
+
+PLUGINLIB_EXPORT_CLASS(dpgo_ros::PGOAgentROSNodelet, nodelet::Nodelet)
@@ -0,0 +1,313 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/PGOAgentROS.h>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+std::optional<PGOAgentROSParameters> loadPGOAgentROSParameters(const ros::NodeHandle &nh_private,
+                                                               unsigned &agent_id) {
+  /**
+  ###########################################
+  Read unique ID of this agent
+  ###########################################
+  */
+  int ID = -1;
+  nh_private.getParam("agent_id", ID);
+  if (ID < 0) {
+    ROS_ERROR_STREAM("Negative agent id! ");
+    return std::nullopt;
+  }
+
+  /**
+  ###########################################
+  Load required options
+  ###########################################
+  */
+  int d = -1;
+  int r = -1;
+  int num_robots = 0;
+  if (!nh_private.getParam("num_robots", num_robots)) {
+    ROS_ERROR("Failed to get number of robots!");
+    return std::nullopt;
+  }
+  if (num_robots <= 0) {
+    ROS_ERROR_STREAM("Number of robots must be positive!");
+    return std::nullopt;
+  }
+  if (ID >= num_robots) {
+    ROS_ERROR_STREAM("ID greater than number of robots!");
+    return std::nullopt;
+  }
+  if (!nh_private.getParam("dimension", d)) {
+    ROS_ERROR("Failed to get dimension!");
+    return std::nullopt;
+  }
+  if (!nh_private.getParam("relaxation_rank", r)) {
+    ROS_ERROR("Failed to get relaxation rank!");
+    return std::nullopt;
+  }
+  if (d != 3) {
+    ROS_ERROR_STREAM("Dimension must be 3!");
+    return std::nullopt;
+  }
+  if (r < d) {
+    ROS_ERROR_STREAM("Relaxation rank cannot be smaller than dimension!");
+    return std::nullopt;
+  }
+
+  PGOAgentROSParameters params(d, r, num_robots);
+
+  /**
+  ###########################################
+  Load optional options
+  ###########################################
+  */
+  // Run in asynchronous mode
+  nh_private.getParam("asynchronous", params.asynchronous);
+
+  if (!params.asynchronous) {
+    // Synchronous mode
+    // Use Riemannian trust-region solver
+    params.localOptimizationParams.method = ROptParameters::ROptMethod::RTR;
+  } else {
+    // Asynchronous mode
+    ROS_WARN("Running asynchronous mode.");
+    // Use gradient descent in asynchronous mode
+    params.localOptimizationParams.method = ROptParameters::ROptMethod::RGD;
+    // Frequency of optimization loop in asynchronous mode
+    nh_private.getParam("asynchronous_rate", params.asynchronousOptimizationRate);
+  }
+
+  // Local Riemannian optimization options
+  nh_private.getParam("RGD_stepsize", params.localOptimizationParams.RGD_stepsize);
+  nh_private.getParam("RGD_use_preconditioner", params.localOptimizationParams.RGD_use_preconditioner);
+  nh_private.getParam("RTR_iterations", params.localOptimizationParams.RTR_iterations);
+  nh_private.getParam("RTR_tCG_iterations", params.localOptimizationParams.RTR_tCG_iterations);
+  nh_private.getParam("RTR_gradnorm_tol", params.localOptimizationParams.gradnorm_tol);
+
+  // Local initialization
+  std::string initMethodName;
+  if (nh_private.getParam("local_initialization_method", initMethodName)) {
+    if (initMethodName == "Odometry") {
+      params.localInitializationMethod = InitializationMethod::Odometry;
+    }
+    else if (initMethodName == "Chordal") {
+      params.localInitializationMethod = InitializationMethod::Chordal;
+    }
+    else if (initMethodName == "GNC_TLS") {
+      params.localInitializationMethod = InitializationMethod::GNC_TLS;
+    }
+    else {
+      ROS_ERROR_STREAM("Invalid local initialization method: " << initMethodName);
+    }
+  }
+
+  // Cross-robot initialization
+  nh_private.getParam("multirobot_initialization", params.multirobotInitialization);
+  if (!params.multirobotInitialization) {
+    ROS_WARN("DPGO cross-robot initialization is OFF.");
+  }
+
+  // Nesterov acceleration parameters
+  nh_private.getParam("acceleration", params.acceleration);
+  int restart_interval_int;
+  if (nh_private.getParam("restart_interval", restart_interval_int)) {
+    params.restartInterval = (unsigned) restart_interval_int;
+  }
+
+  // Maximum delayed iterations
+  nh_private.getParam("max_delayed_iterations", params.maxDelayedIterations);
+
+  // Inter update sleep time
+  nh_private.getParam("inter_update_sleep_time", params.interUpdateSleepTime);
+
+  // Threshold for determining measurement weight convergence
+  nh_private.getParam("weight_convergence_threshold", params.weightConvergenceThreshold);
+
+  // Timeout threshold for considering a robot disconnected
+  nh_private.getParam("timeout_threshold", params.timeoutThreshold);
+  nh_private.getParam("pose_graph_query_timeout", params.poseGraphQueryTimeout);
+
+  // Acknowledgement and retransmission of commands
+  nh_private.getParam("max_command_retransmissions", params.maxCommandRetransmissions);
+  nh_private.getParam("command_ack_timeout", params.commandAckTimeout);
+
+  // Adaptive failure detection
+  nh_private.getParam("adaptive_failure_detection", params.adaptiveFailureDetection);
+  nh_private.getParam("heartbeat_period", params.heartbeatPeriod);
+  nh_private.getParam("phi_threshold", params.phiThreshold);
+
+  // Leader failover
+  nh_private.getParam("leader_failover", params.leaderFailover);
+
+  // Reject converged outliers after every GNC weight update
+  nh_private.getParam("reject_outliers_at_weight_update", params.rejectOutliersAtWeightUpdate);
+
+  // Permanently fix loop closure weights that stay converged for this many weight updates
+  nh_private.getParam("weight_fixing_patience", params.weightFixingPatience);
+
+  // Checkpoint file used for warm restart
+  nh_private.getParam("checkpoint_path", params.checkpointPath);
+
+  // Prefix of the topics published by other agents
+  nh_private.getParam("incoming_topic_prefix", params.incomingTopicPrefix);
+
+  // Add new measurements during optimization
+  nh_private.getParam("online_pose_graph_update", params.onlinePoseGraphUpdate);
+  nh_private.getParam("online_update_period", params.onlineUpdatePeriod);
+
+  // Scheduling of optimization rounds
+  nh_private.getParam("change_triggered_rounds", params.changeTriggeredRounds);
+  nh_private.getParam("pose_graph_summary_period", params.poseGraphSummaryPeriod);
+  nh_private.getParam("round_trigger_loop_closures", params.roundTriggerLoopClosures);
+  nh_private.getParam("min_round_interval", params.minRoundInterval);
+  nh_private.getParam("max_round_interval", params.maxRoundInterval);
+
+  // Termination based on the predicted remaining cost decrease
+  nh_private.getParam("predictive_termination", params.predictiveTermination);
+  nh_private.getParam("prediction_window", params.predictionWindow);
+  nh_private.getParam("predicted_decrease_tolerance", params.predictedDecreaseTolerance);
+  nh_private.getParam("global_gradnorm_tolerance", params.globalGradNormTolerance);
+
+  // Odometry chain reduction
+  nh_private.getParam("reduce_odometry_chains", params.reduceOdometryChains);
+  nh_private.getParam("keyframe_interval", params.keyframeInterval);
+
+  // Caches of neighbor poses and edge weights
+  nh_private.getParam("neighbor_cache_capacity", params.neighborCacheCapacity);
+  nh_private.getParam("neighbor_cache_eviction_rounds", params.neighborCacheEvictionRounds);
+
+  // Adaptive relaxation rank
+  nh_private.getParam("adaptive_relaxation_rank", params.adaptiveRelaxationRank);
+  nh_private.getParam("rank_deficiency_tolerance", params.rankDeficiencyTolerance);
+
+  // Time budget of local solves
+  nh_private.getParam("local_solve_time_budget", params.localSolveTimeBudget);
+  nh_private.getParam("time_budget_median_factor", params.timeBudgetMedianFactor);
+
+  // Load-balanced update rule
+  nh_private.getParam("load_balance_min_weight", params.loadBalanceMinWeight);
+
+  // Data matrix reuse across rounds
+  nh_private.getParam("reuse_data_matrices", params.reuseDataMatrices);
+
+  // Stopping condition in terms of relative change
+  nh_private.getParam("relative_change_tolerance", params.relChangeTol);
+
+  // Verbose flag
+  nh_private.getParam("verbose", params.verbose);
+
+  // Publish iterate during optimization
+  nh_private.getParam("publish_iterate", params.publishIterate);
+
+  // Publish loop closures as ROS markers for visualization
+  nh_private.getParam("visualize_loop_closures", params.visualizeLoopClosures);
+
+  // Completely reset dpgo after each distributed optimization round
+  nh_private.getParam("complete_reset", params.completeReset);
+
+  // Try to recover and resume optimization after disconnection
+  nh_private.getParam("enable_recovery", params.enableRecovery);
+
+  // Synchronize shared measurements between robots before each optimization round
+  nh_private.getParam("synchronize_measurements", params.synchronizeMeasurements);
+
+  // Maximum multi-robot initialization attempts 
+  nh_private.getParam("max_distributed_init_steps", params.maxDistributedInitSteps);
+
+  // Logging
+  params.logData = nh_private.getParam("log_output_path", params.logDirectory);
+  if (params.logDirectory.empty()) {
+    params.logData = false;
+  }
+
+  // Robust cost function
+  std::string costName;
+  if (nh_private.getParam("robust_cost_type", costName)) {
+    if (costName == "L2") {
+      params.robustCostParams.costType = RobustCostParameters::Type::L2;
+    } else if (costName == "L1") {
+      params.robustCostParams.costType = RobustCostParameters::Type::L1;
+    } else if (costName == "Huber") {
+      params.robustCostParams.costType = RobustCostParameters::Type::Huber;
+    } else if (costName == "TLS") {
+      params.robustCostParams.costType = RobustCostParameters::Type::TLS;
+    } else if (costName == "GM") {
+      params.robustCostParams.costType = RobustCostParameters::Type::GM;
+    } else if (costName == "GNC_TLS") {
+      params.robustCostParams.costType = RobustCostParameters::Type::GNC_TLS;
+    } else {
+      ROS_ERROR_STREAM("Unknown robust cost type: " << costName);
+      return std::nullopt;
+    }
+  }
+
+  // GNC parameters
+  bool gnc_use_quantile = false;
+  nh_private.getParam("GNC_use_probability", gnc_use_quantile);
+  if (gnc_use_quantile) {
+    double gnc_quantile = 0.9;
+    nh_private.getParam("GNC_quantile", gnc_quantile);
+    double gnc_barc = RobustCost::computeErrorThresholdAtQuantile(gnc_quantile, 3);
+    params.robustCostParams.GNCBarc = gnc_barc;
+    ROS_INFO("PGOAgentROS: set GNC confidence quantile at %f (barc %f).", gnc_quantile, gnc_barc);
+  } else {
+    double gnc_barc = 5.0;
+    nh_private.getParam("GNC_barc", gnc_barc);
+    params.robustCostParams.GNCBarc = gnc_barc;
+    ROS_INFO("PGOAgentROS: set GNC barc at %f.", gnc_barc);
+  }
+  nh_private.getParam("GNC_mu_step", params.robustCostParams.GNCMuStep);
+  nh_private.getParam("GNC_init_mu", params.robustCostParams.GNCInitMu);
+  nh_private.getParam("robust_opt_num_weight_updates", params.robustOptNumWeightUpdates);
+  nh_private.getParam("robust_opt_num_resets", params.robustOptNumResets);
+  nh_private.getParam("robust_opt_min_convergence_ratio", params.robustOptMinConvergenceRatio);
+  int robust_opt_inner_iters_per_robot = 10;
+  nh_private.getParam("robust_opt_inner_iters_per_robot", robust_opt_inner_iters_per_robot);
+  params.robustOptInnerIters = num_robots * robust_opt_inner_iters_per_robot;
+  int robust_init_min_inliers;
+  if (nh_private.getParam("robust_init_min_inliers", robust_init_min_inliers)) {
+    params.robustInitMinInliers = (unsigned) robust_init_min_inliers;
+  }
+
+  // Maximum number of iterations
+  int max_iters_int;
+  if (nh_private.getParam("max_iteration_number", max_iters_int))
+    params.maxNumIters = (unsigned) max_iters_int;
+  // For robust optimization, we set the number of iterations based on the number of GNC iterations
+  if (costName != "L2") {
+    max_iters_int = (params.robustOptNumWeightUpdates + 1) * params.robustOptInnerIters - 2;
+    max_iters_int = std::max(max_iters_int, 0);
+    params.maxNumIters = (unsigned) max_iters_int;
+  }
+
+  // Update rule
+  std::string update_rule_str;
+  if (nh_private.getParam("update_rule", update_rule_str)) {
+    if (update_rule_str == "Uniform") {
+      params.updateRule = PGOAgentROSParameters::UpdateRule::Uniform;
+    } else if (update_rule_str == "RoundRobin") {
+      params.updateRule = PGOAgentROSParameters::UpdateRule::RoundRobin;
+    } else if (update_rule_str == "LoadBalanced") {
+      params.updateRule = PGOAgentROSParameters::UpdateRule::LoadBalanced;
+    } else {
+      ROS_ERROR_STREAM("Unknown update rule: " << update_rule_str);
+      return std::nullopt;
+    }
+  }
+
+  // Print params
+  ROS_INFO_STREAM("Initializing PGOAgent " << ID << " with params: \n" << params);
+
+  agent_id = (unsigned) ID;
+  return params;
+}
+
+}  // namespace dpgo_ros
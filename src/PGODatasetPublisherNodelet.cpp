@@ -0,0 +1,30 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/DatasetPublisher.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <memory>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Nodelet version of dpgo_ros_dataset_publisher_node
+ */
+class PGODatasetPublisherNodelet : public nodelet::Nodelet {
+ private:
+  std::unique_ptr<DatasetPublisher> mDatasetPublisher;
+
+  void onInit() override {
+    mDatasetPublisher = std::make_unique<DatasetPublisher>(getNodeHandle(), getPrivateNodeHandle());
+  }
+};
+
+}  // namespace dpgo_ros
+
+PLUGINLIB_EXPORT_CLASS(dpgo_ros::PGODatasetPublisherNodelet, nodelet::Nodelet)
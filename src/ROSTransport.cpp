@@ -0,0 +1,99 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/ROSTransport.h>
+
+namespace dpgo_ros {
+
+namespace {
+
+// Report the receipt time of a message before handing it to the callback
+template <typename M>
+struct ArrivalCallback {
+  std::function<void(const boost::shared_ptr<M const> &)> callback;
+  std::function<void(const ros::Time &)> arrival;
+
+  void handle(const ros::MessageEvent<M const> &event) {
+    if (arrival) arrival(event.getReceiptTime());
+    callback(event.getMessage());
+  }
+};
+
+template <typename M>
+ros::Subscriber subscribeWithArrival(ros::NodeHandle &nh, const std::string &topic,
+                                     const std::function<void(const boost::shared_ptr<M const> &)> &callback,
+                                     const std::function<void(const ros::Time &)> &arrival) {
+  auto adapter = boost::make_shared<ArrivalCallback<M>>();
+  adapter->callback = callback;
+  adapter->arrival = arrival;
+  return nh.subscribe(topic, 100, &ArrivalCallback<M>::handle, adapter);
+}
+
+}  // namespace
+
+ROSTransport::ROSTransport(const ros::NodeHandle &nh_,
+                           const std::map<unsigned, std::string> &robot_names,
+                           const std::string &topic_prefix)
+    : nh(nh_), mRobotNames(robot_names), mTopicPrefix(topic_prefix) {
+  mLiftingMatrixPublisher = nh.advertise<MatrixMsg>("lifting_matrix", 1);
+  mAnchorPublisher = nh.advertise<PublicPoses>("anchor", 1);
+  mStatusPublisher = nh.advertise<Status>("status", 1);
+  mCommandPublisher = nh.advertise<Command>("command", 20);
+  mPublicPosesPublisher = nh.advertise<PublicPoses>("public_poses", 20);
+  mPublicMeasurementsPublisher = nh.advertise<RelativeMeasurementList>("public_measurements", 20);
+  mMeasurementWeightsPublisher = nh.advertise<RelativeMeasurementWeights>("measurement_weights", 20);
+}
+
+void ROSTransport::publishCommand(const CommandConstPtr &msg) {
+  mCommandPublisher.publish(msg);
+}
+
+void ROSTransport::publishStatus(const StatusConstPtr &msg) {
+  mStatusPublisher.publish(msg);
+}
+
+void ROSTransport::publishPublicPoses(const PublicPosesConstPtr &msg) {
+  mPublicPosesPublisher.publish(msg);
+}
+
+void ROSTransport::publishAnchor(const PublicPosesConstPtr &msg) {
+  mAnchorPublisher.publish(msg);
+}
+
+void ROSTransport::publishLiftingMatrix(const MatrixMsgConstPtr &msg) {
+  mLiftingMatrixPublisher.publish(msg);
+}
+
+void ROSTransport::publishPublicMeasurements(const RelativeMeasurementListConstPtr &msg) {
+  mPublicMeasurementsPublisher.publish(msg);
+}
+
+void ROSTransport::publishMeasurementWeights(const RelativeMeasurementWeightsConstPtr &msg) {
+  mMeasurementWeightsPublisher.publish(msg);
+}
+
+void ROSTransport::subscribe(unsigned robot_id, const PGOAgentMessageHandlers &handlers) {
+  const std::string topic_prefix = mTopicPrefix + "/" + mRobotNames.at(robot_id) + "/dpgo_ros_node/";
+  if (handlers.lifting_matrix)
+    mSubscribers.push_back(nh.subscribe<MatrixMsg>(topic_prefix + "lifting_matrix", 100, handlers.lifting_matrix));
+  if (handlers.status)
+    mSubscribers.push_back(subscribeWithArrival(nh, topic_prefix + "status", handlers.status, handlers.arrival));
+  if (handlers.command)
+    mSubscribers.push_back(subscribeWithArrival(nh, topic_prefix + "command", handlers.command, handlers.arrival));
+  if (handlers.anchor)
+    mSubscribers.push_back(nh.subscribe<PublicPoses>(topic_prefix + "anchor", 100, handlers.anchor));
+  if (handlers.public_poses)
+    mSubscribers.push_back(nh.subscribe<PublicPoses>(topic_prefix + "public_poses", 100, handlers.public_poses));
+  if (handlers.public_measurements)
+    mSubscribers.push_back(nh.subscribe<RelativeMeasurementList>(
+        topic_prefix + "public_measurements", 100, handlers.public_measurements));
+  if (handlers.measurement_weights)
+    mSubscribers.push_back(nh.subscribe<RelativeMeasurementWeights>(
+        topic_prefix + "measurement_weights", 100, handlers.measurement_weights));
+}
+
+}  // namespace dpgo_ros
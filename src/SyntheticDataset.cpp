@@ -0,0 +1,214 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/SyntheticDataset.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+namespace dpgo_ros {
+
+namespace {
+
+// Number of random visits inspected when searching for a loop closure candidate
+const unsigned kMaxCandidateTrials = 8;
+// Minimum separation between the two poses of a private loop closure
+const unsigned kMinLoopClosureSeparation = 10;
+// Lower bound on the noise used to compute measurement precisions
+const double kMinNoiseStd = 1e-3;
+
+// Pose on the grid, with heading in multiples of 90 degrees about the z axis
+struct GridPose {
+  int x = 0;
+  int y = 0;
+  int z = 0;
+  int heading = 0;
+};
+
+Matrix gridRotation(const GridPose &pose, unsigned d) {
+  const double yaw = pose.heading * M_PI / 2;
+  Matrix R = Matrix::Identity(d, d);
+  R(0, 0) = std::cos(yaw);
+  R(0, 1) = -std::sin(yaw);
+  R(1, 0) = std::sin(yaw);
+  R(1, 1) = std::cos(yaw);
+  return R;
+}
+
+Matrix gridTranslation(const GridPose &pose, unsigned d) {
+  Matrix t(d, 1);
+  t(0) = pose.x;
+  t(1) = pose.y;
+  if (d == 3) t(2) = pose.z;
+  return t;
+}
+
+Matrix rotationFromAxisAngle(const Eigen::Vector3d &w) {
+  const double angle = w.norm();
+  if (angle < 1e-12) return Matrix::Identity(3, 3);
+  return Eigen::AngleAxisd(angle, w / angle).toRotationMatrix();
+}
+
+Matrix planarRotation(double angle) {
+  Matrix R(2, 2);
+  R << std::cos(angle), -std::sin(angle), std::sin(angle), std::cos(angle);
+  return R;
+}
+
+}  // namespace
+
+SyntheticDataset generateSyntheticDataset(const SyntheticDatasetParameters &params) {
+  const unsigned d = params.d;
+  const unsigned num_robots = params.numRobots;
+  const unsigned n = params.numPosesPerRobot;
+  const int side = std::max(2u, params.numCellsPerSide);
+  const int num_layers = d == 3 ? side : 1;
+  std::mt19937 rng(params.seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::normal_distribution<double> normal(0.0, 1.0);
+
+  const double rotation_std = std::max(params.rotationNoiseStd, kMinNoiseStd);
+  const double translation_std = std::max(params.translationNoiseStd, kMinNoiseStd);
+  const double kappa = 1.0 / (2 * rotation_std * rotation_std);
+  const double tau = 1.0 / (translation_std * translation_std);
+
+  auto noisyMeasurement = [&](const GridPose &src, const GridPose &dst, bool outlier) {
+    Matrix R, t;
+    if (outlier) {
+      if (d == 3) {
+        Eigen::Quaterniond q(normal(rng), normal(rng), normal(rng), normal(rng));
+        R = q.normalized().toRotationMatrix();
+      } else {
+        R = planarRotation(2 * M_PI * uniform(rng));
+      }
+      t = Matrix(d, 1);
+      for (unsigned i = 0; i < d; ++i) t(i) = side * (2 * uniform(rng) - 1);
+    } else {
+      const Matrix Rsrc = gridRotation(src, d);
+      R = Rsrc.transpose() * gridRotation(dst, d);
+      t = Rsrc.transpose() * (gridTranslation(dst, d) - gridTranslation(src, d));
+      if (d == 3) {
+        const Eigen::Vector3d w(normal(rng), normal(rng), normal(rng));
+        R = R * rotationFromAxisAngle(params.rotationNoiseStd * w);
+      } else {
+        R = R * planarRotation(params.rotationNoiseStd * normal(rng));
+      }
+      for (unsigned i = 0; i < d; ++i) t(i) += params.translationNoiseStd * normal(rng);
+    }
+    return std::make_pair(R, t);
+  };
+
+  SyntheticDataset dataset;
+  dataset.measurements.resize(num_robots);
+  std::vector<std::vector<GridPose>> trajectories(num_robots);
+  for (unsigned robot = 0; robot < num_robots; ++robot) {
+    dataset.measurements[robot].reserve(n + n / 4);
+    trajectories[robot].reserve(n);
+  }
+
+  // Poses that visited each cell
+  std::unordered_map<uint64_t, std::vector<PoseID>> visits;
+  auto cellKey = [&](const GridPose &pose) {
+    return ((uint64_t) pose.z * side + pose.y) * side + pose.x;
+  };
+
+  auto addLoopClosure = [&](const PoseID &src_id, const PoseID &dst_id) {
+    const bool outlier = uniform(rng) < params.outlierFraction;
+    const auto Rt = noisyMeasurement(trajectories[src_id.robot_id][src_id.frame_id],
+                                     trajectories[dst_id.robot_id][dst_id.frame_id], outlier);
+    RelativeSEMeasurement m(src_id.robot_id, dst_id.robot_id,
+                            src_id.frame_id, dst_id.frame_id,
+                            Rt.first, Rt.second, kappa, tau);
+    dataset.measurements[src_id.robot_id].push_back(m);
+    if (src_id.robot_id != dst_id.robot_id) {
+      dataset.measurements[dst_id.robot_id].push_back(m);
+      dataset.numInterLoopClosures++;
+    } else {
+      dataset.numIntraLoopClosures++;
+    }
+    if (outlier) dataset.numOutliers++;
+  };
+
+  // All robots move simultaneously so that loop closures are added in both directions
+  for (unsigned k = 0; k < n; ++k) {
+    for (unsigned robot = 0; robot < num_robots; ++robot) {
+      auto &trajectory = trajectories[robot];
+      GridPose pose;
+      if (k == 0) {
+        pose.x = (int) (uniform(rng) * side);
+        pose.y = (int) (uniform(rng) * side);
+        pose.z = (int) (uniform(rng) * num_layers);
+        pose.heading = (int) (uniform(rng) * 4);
+      } else {
+        pose = trajectory.back();
+        if (uniform(rng) < params.turnProbability)
+          pose.heading = (pose.heading + (uniform(rng) < 0.5 ? 1 : 3)) % 4;
+        if (d == 3 && uniform(rng) < params.turnProbability / 4) {
+          // Change layer
+          const int dz = (pose.z == 0 || (pose.z + 1 < num_layers && uniform(rng) < 0.5)) ? 1 : -1;
+          pose.z += dz;
+        } else {
+          const int dx[4] = {1, 0, -1, 0};
+          const int dy[4] = {0, 1, 0, -1};
+          if (pose.x + dx[pose.heading] < 0 || pose.x + dx[pose.heading] >= side ||
+              pose.y + dy[pose.heading] < 0 || pose.y + dy[pose.heading] >= side) {
+            // Turn around at the boundary
+            pose.heading = (pose.heading + 2) % 4;
+          }
+          pose.x += dx[pose.heading];
+          pose.y += dy[pose.heading];
+        }
+      }
+      trajectory.push_back(pose);
+
+      // Odometry
+      if (k > 0) {
+        const auto Rt = noisyMeasurement(trajectory[k - 1], pose, false);
+        dataset.measurements[robot].emplace_back(robot, robot, k - 1, k,
+                                                 Rt.first, Rt.second, kappa, tau);
+      }
+
+      // Loop closures with previous visits of the same cell
+      auto &cell_visits = visits[cellKey(pose)];
+      if (!cell_visits.empty()) {
+        const bool try_intra = uniform(rng) < params.intraLoopClosureProbability;
+        const bool try_inter = uniform(rng) < params.interLoopClosureProbability;
+        bool found_intra = !try_intra;
+        bool found_inter = !try_inter;
+        for (unsigned trial = 0; trial < kMaxCandidateTrials && !(found_intra && found_inter); ++trial) {
+          const PoseID &candidate = cell_visits[(size_t) (uniform(rng) * cell_visits.size())];
+          if (candidate.robot_id == robot) {
+            if (found_intra || candidate.frame_id + kMinLoopClosureSeparation > k) continue;
+            addLoopClosure(candidate, PoseID(robot, k));
+            found_intra = true;
+          } else if (!found_inter) {
+            addLoopClosure(candidate, PoseID(robot, k));
+            found_inter = true;
+          }
+        }
+      }
+      cell_visits.emplace_back(robot, k);
+    }
+  }
+
+  if (params.storeGroundTruth) {
+    for (unsigned robot = 0; robot < num_robots; ++robot) {
+      PoseArray T(d, n);
+      for (unsigned k = 0; k < n; ++k) {
+        T.rotation(k) = gridRotation(trajectories[robot][k], d);
+        T.translation(k) = gridTranslation(trajectories[robot][k], d);
+      }
+      dataset.groundTruth.push_back(T);
+    }
+  }
+  return dataset;
+}
+
+}  // namespace dpgo_ros
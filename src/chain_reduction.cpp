@@ -0,0 +1,172 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/chain_reduction.h>
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+
+namespace dpgo_ros {
+
+namespace {
+
+// Fraction s of a rotation along the geodesic from the identity
+Matrix interpolateRotation(const Matrix &R, double s) {
+  if (R.rows() == 2) {
+    const double angle = std::atan2(R(1, 0), R(0, 0));
+    return Eigen::Rotation2Dd(s * angle).toRotationMatrix();
+  }
+  Eigen::AngleAxisd aa{Eigen::Matrix3d(R)};
+  aa.angle() *= s;
+  return aa.toRotationMatrix();
+}
+
+}  // namespace
+
+std::vector<RelativeSEMeasurement> reduceOdometryChains(unsigned robot_id,
+                                                        const std::vector<RelativeSEMeasurement> &measurements,
+                                                        unsigned keyframe_interval,
+                                                        ChainReduction &reduction) {
+  auto isOdometry = [robot_id](const RelativeSEMeasurement &m) {
+    return m.r1 == robot_id && m.r2 == robot_id && m.p1 + 1 == m.p2;
+  };
+
+  size_t num_poses = 0;
+  for (const auto &m : measurements) {
+    if (m.r1 == robot_id) num_poses = std::max(num_poses, m.p1 + 1);
+    if (m.r2 == robot_id) num_poses = std::max(num_poses, m.p2 + 1);
+  }
+  reduction.odometry.assign(num_poses, RelativeSEMeasurement());
+  std::vector<bool> has_odometry(num_poses, false);
+  std::vector<bool> kept(num_poses, false);
+  for (const auto &m : measurements) {
+    if (isOdometry(m)) {
+      reduction.odometry[m.p1] = m;
+      has_odometry[m.p1] = true;
+      continue;
+    }
+    if (m.r1 == robot_id) kept[m.p1] = true;
+    if (m.r2 == robot_id) kept[m.p2] = true;
+  }
+  for (size_t i = 0; i < num_poses; ++i) {
+    if (i == 0 || i + 1 == num_poses) kept[i] = true;
+    if (keyframe_interval > 0 && i % keyframe_interval == 0) kept[i] = true;
+    if (i + 1 < num_poses && !has_odometry[i]) {
+      kept[i] = true;
+      kept[i + 1] = true;
+    }
+  }
+  // A private loop closure between kept poses with no kept pose in between would get
+  // the same endpoints as the composed odometry, and would be taken for it. Keep an
+  // interior pose of such chains.
+  std::vector<unsigned> num_kept_before(num_poses + 1, 0);
+  for (size_t i = 0; i < num_poses; ++i) num_kept_before[i + 1] = num_kept_before[i] + kept[i];
+  for (const auto &m : measurements) {
+    if (m.r1 != robot_id || m.r2 != robot_id || isOdometry(m)) continue;
+    const size_t first = std::min(m.p1, m.p2);
+    const size_t last = std::max(m.p1, m.p2);
+    if (last < first + 2) continue;
+    if (num_kept_before[last] == num_kept_before[first + 1]) kept[(first + last) / 2] = true;
+  }
+
+  reduction.keptPoses.clear();
+  reduction.reducedIndices.assign(num_poses, -1);
+  for (size_t i = 0; i < num_poses; ++i) {
+    if (!kept[i]) continue;
+    reduction.reducedIndices[i] = (int) reduction.keptPoses.size();
+    reduction.keptPoses.push_back(i);
+  }
+
+  std::vector<RelativeSEMeasurement> reduced_measurements;
+  // Compose odometry between consecutive kept poses
+  for (size_t k = 0; k + 1 < reduction.keptPoses.size(); ++k) {
+    const unsigned start = reduction.keptPoses[k];
+    const unsigned end = reduction.keptPoses[k + 1];
+    if (!has_odometry[start]) continue;
+    const auto &first = reduction.odometry[start];
+    Matrix R = first.R;
+    Matrix t = first.t;
+    double rotation_variance = 1 / first.kappa;
+    double translation_variance = 1 / first.tau;
+    for (unsigned i = start + 1; i < end; ++i) {
+      const auto &m = reduction.odometry[i];
+      // Rotation noise accumulated so far also perturbs the translation of this step
+      translation_variance += 1 / m.tau + rotation_variance * m.t.squaredNorm();
+      rotation_variance += 1 / m.kappa;
+      t = t + R * m.t;
+      R = R * m.R;
+    }
+    RelativeSEMeasurement m(robot_id, robot_id, k, k + 1, R, t,
+                            1 / rotation_variance, 1 / translation_variance);
+    m.fixedWeight = true;
+    reduced_measurements.push_back(m);
+  }
+  // Loop closures keep their endpoints, which are always kept poses
+  for (const auto &m : measurements) {
+    if (isOdometry(m)) continue;
+    RelativeSEMeasurement reduced = m;
+    if (m.r1 == robot_id) reduced.p1 = reduction.reducedIndices[m.p1];
+    if (m.r2 == robot_id) reduced.p2 = reduction.reducedIndices[m.p2];
+    reduced_measurements.push_back(reduced);
+  }
+  return reduced_measurements;
+}
+
+RelativeSEMeasurement expandMeasurement(unsigned robot_id, const ChainReduction &reduction,
+                                        const RelativeSEMeasurement &m) {
+  RelativeSEMeasurement full_m = m;
+  if (m.r1 == robot_id) full_m.p1 = reduction.fullIndex(m.p1);
+  if (m.r2 == robot_id) full_m.p2 = reduction.fullIndex(m.p2);
+  return full_m;
+}
+
+bool reduceMeasurement(unsigned robot_id, const ChainReduction &reduction, RelativeSEMeasurement &m) {
+  int p1 = m.p1;
+  int p2 = m.p2;
+  if (m.r1 == robot_id) p1 = reduction.reducedIndex(m.p1);
+  if (m.r2 == robot_id) p2 = reduction.reducedIndex(m.p2);
+  if (p1 < 0 || p2 < 0) return false;
+  m.p1 = p1;
+  m.p2 = p2;
+  return true;
+}
+
+PoseArray expandTrajectory(const ChainReduction &reduction, const PoseArray &reduced_poses) {
+  const unsigned d = reduced_poses.d();
+  PoseArray T(d, reduction.numPoses());
+  for (unsigned k = 0; k < reduction.numKeptPoses(); ++k) {
+    const unsigned start = reduction.keptPoses[k];
+    T.pose(start) = reduced_poses.pose(k);
+    if (k + 1 == reduction.numKeptPoses()) break;
+    const unsigned end = reduction.keptPoses[k + 1];
+    if (end == start + 1) continue;
+
+    // Propagate odometry from the kept pose at the start of the chain
+    for (unsigned i = start + 1; i <= end; ++i) {
+      const auto &m = reduction.odometry[i - 1];
+      T.translation(i) = T.translation(i - 1) + T.rotation(i - 1) * m.t;
+      T.rotation(i) = T.rotation(i - 1) * m.R;
+    }
+    // Distribute the correction to the kept pose at the end of the chain,
+    // rotating about the start of the chain
+    const Matrix t_start = T.translation(start);
+    const Matrix R_end = reduced_poses.rotation(k + 1);
+    const Matrix t_end = reduced_poses.translation(k + 1);
+    const Matrix R_correction = R_end * T.rotation(end).transpose();
+    const Matrix t_correction = t_end - t_start - R_correction * (T.translation(end) - t_start);
+    for (unsigned i = start + 1; i < end; ++i) {
+      const double s = (double) (i - start) / (end - start);
+      const Matrix R_s = interpolateRotation(R_correction, s);
+      T.translation(i) = t_start + R_s * (T.translation(i) - t_start) + s * t_correction;
+      T.rotation(i) = R_s * T.rotation(i);
+    }
+  }
+  return T;
+}
+
+}  // namespace dpgo_ros
@@ -0,0 +1,238 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/checkpoint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+namespace dpgo_ros {
+
+namespace {
+
+const uint32_t kCheckpointMagic = 0x4B435044;  // "DPCK"
+const uint32_t kCheckpointVersion = 1;
+
+template <typename T>
+void writeValue(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::ifstream &in, T &value) {
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return in.good();
+}
+
+void writeMatrix(std::ofstream &out, const Matrix &M) {
+  writeValue<uint32_t>(out, M.rows());
+  writeValue<uint32_t>(out, M.cols());
+  out.write(reinterpret_cast<const char *>(M.data()), sizeof(double) * M.size());
+}
+
+// Number of bytes after the current read position
+uint64_t remainingBytes(std::ifstream &in) {
+  const auto pos = in.tellg();
+  in.seekg(0, std::ios::end);
+  const auto end = in.tellg();
+  in.seekg(pos);
+  if (pos < 0 || end < pos) return 0;
+  return end - pos;
+}
+
+// Read a matrix of the expected size. The stored size is checked before allocating,
+// so that a corrupt file cannot trigger a huge allocation or load a matrix of the wrong size.
+bool readMatrix(std::ifstream &in, Matrix &M, uint64_t rows, uint64_t cols) {
+  uint32_t stored_rows, stored_cols;
+  if (!readValue(in, stored_rows) || !readValue(in, stored_cols)) return false;
+  if (stored_rows != rows || stored_cols != cols) return false;
+  if (rows * cols * sizeof(double) > remainingBytes(in)) return false;
+  M.resize(rows, cols);
+  in.read(reinterpret_cast<char *>(M.data()), sizeof(double) * M.size());
+  return in.good();
+}
+
+// Read the number of entries of a list, where each entry takes at least entry_size bytes
+bool readNumEntries(std::ifstream &in, uint64_t entry_size, uint64_t &num_entries) {
+  if (!readValue(in, num_entries)) return false;
+  return num_entries <= remainingBytes(in) / entry_size;
+}
+
+// Flush a file or directory to disk
+bool syncPath(const std::string &path, int flags) {
+  const int fd = ::open(path.c_str(), flags);
+  if (fd < 0) return false;
+  const bool success = ::fsync(fd) == 0;
+  ::close(fd);
+  return success;
+}
+
+void writePoseID(std::ofstream &out, const PoseID &id) {
+  writeValue<uint32_t>(out, id.robot_id);
+  writeValue<uint32_t>(out, id.frame_id);
+}
+
+bool readPoseID(std::ifstream &in, PoseID &id) {
+  uint32_t robot_id, frame_id;
+  if (!readValue(in, robot_id) || !readValue(in, frame_id)) return false;
+  id = PoseID(robot_id, frame_id);
+  return true;
+}
+
+}  // namespace
+
+bool writeCheckpoint(const std::string &path, const AgentCheckpoint &checkpoint) {
+  const std::string tmp_path = path + ".tmp";
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) return false;
+
+  writeValue(out, kCheckpointMagic);
+  writeValue(out, kCheckpointVersion);
+  writeValue<uint32_t>(out, checkpoint.robot_id);
+  writeValue<uint32_t>(out, checkpoint.d);
+  writeValue<uint32_t>(out, checkpoint.r);
+
+  writeValue<uint8_t>(out, checkpoint.poses.has_value());
+  if (checkpoint.poses) {
+    writeValue<uint32_t>(out, checkpoint.poses->n());
+    writeMatrix(out, checkpoint.poses->getData());
+  }
+
+  writeValue<uint8_t>(out, checkpoint.lifting_matrix.has_value());
+  if (checkpoint.lifting_matrix) writeMatrix(out, checkpoint.lifting_matrix.value());
+
+  writeValue<uint64_t>(out, checkpoint.neighbor_poses.size());
+  for (const auto &it : checkpoint.neighbor_poses) {
+    writePoseID(out, it.first);
+    writeMatrix(out, it.second.getData());
+  }
+
+  writeValue<uint64_t>(out, checkpoint.edge_weights.size());
+  for (const auto &it : checkpoint.edge_weights) {
+    writePoseID(out, it.first.src_pose_id);
+    writePoseID(out, it.first.dst_pose_id);
+    writeValue<double>(out, it.second);
+  }
+
+  writeValue<uint64_t>(out, checkpoint.measurements.size());
+  for (const auto &m : checkpoint.measurements) {
+    writePoseID(out, PoseID(m.r1, m.p1));
+    writePoseID(out, PoseID(m.r2, m.p2));
+    writeMatrix(out, m.R);
+    writeMatrix(out, m.t);
+    writeValue<double>(out, m.kappa);
+    writeValue<double>(out, m.tau);
+    writeValue<double>(out, m.weight);
+    writeValue<uint8_t>(out, m.fixedWeight);
+  }
+
+  out.close();
+  // The data must be on disk before the rename, otherwise a crash may leave an empty checkpoint
+  if (out.fail() || !syncPath(tmp_path, O_RDONLY)) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  // Persist the rename itself
+  const size_t separator = path.find_last_of('/');
+  const std::string directory =
+      separator == std::string::npos ? "." : path.substr(0, std::max<size_t>(separator, 1));
+  syncPath(directory, O_RDONLY | O_DIRECTORY);
+  return true;
+}
+
+bool readCheckpoint(const std::string &path, AgentCheckpoint &checkpoint) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) return false;
+
+  uint32_t magic, version, robot_id, d, r;
+  if (!readValue(in, magic) || magic != kCheckpointMagic) return false;
+  if (!readValue(in, version) || version != kCheckpointVersion) return false;
+  if (!readValue(in, robot_id) || !readValue(in, d) || !readValue(in, r)) return false;
+  if (d < 2 || d > 3 || r < d) return false;
+
+  AgentCheckpoint result;
+  result.robot_id = robot_id;
+  result.d = d;
+  result.r = r;
+
+  uint8_t has_value;
+  Matrix M;
+  if (!readValue(in, has_value)) return false;
+  if (has_value) {
+    uint32_t n;
+    if (!readValue(in, n) || n == 0 || !readMatrix(in, M, d, (uint64_t) (d + 1) * n)) return false;
+    result.poses.emplace(d, n);
+    result.poses->setData(M);
+  }
+
+  if (!readValue(in, has_value)) return false;
+  if (has_value) {
+    if (!readMatrix(in, M, r, d)) return false;
+    result.lifting_matrix.emplace(M);
+  }
+
+  // Entry sizes in bytes, used to bound the number of entries by the file size
+  const uint64_t pose_id_size = 2 * sizeof(uint32_t);
+  const uint64_t matrix_header_size = 2 * sizeof(uint32_t);
+  uint64_t num_entries;
+  if (!readNumEntries(in, pose_id_size + matrix_header_size + d * (d + 1) * sizeof(double), num_entries))
+    return false;
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    PoseID pose_id;
+    if (!readPoseID(in, pose_id) || !readMatrix(in, M, d, d + 1)) return false;
+    Pose T(d);
+    T.setData(M);
+    result.neighbor_poses[pose_id] = T;
+  }
+
+  if (!readNumEntries(in, 2 * pose_id_size + sizeof(double), num_entries)) return false;
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    PoseID src_id, dst_id;
+    double weight;
+    if (!readPoseID(in, src_id) || !readPoseID(in, dst_id) || !readValue(in, weight)) return false;
+    result.edge_weights[EdgeID(src_id, dst_id)] = weight;
+  }
+
+  const uint64_t measurement_size = 2 * pose_id_size + 2 * matrix_header_size +
+                                    d * (d + 1) * sizeof(double) + 3 * sizeof(double) + sizeof(uint8_t);
+  if (!readNumEntries(in, measurement_size, num_entries)) return false;
+  result.measurements.reserve(num_entries);
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    PoseID src_id, dst_id;
+    Matrix R, t;
+    double kappa, tau, weight;
+    uint8_t fixed_weight;
+    if (!readPoseID(in, src_id) || !readPoseID(in, dst_id) ||
+        !readMatrix(in, R, d, d) || !readMatrix(in, t, d, 1) ||
+        !readValue(in, kappa) || !readValue(in, tau) ||
+        !readValue(in, weight) || !readValue(in, fixed_weight))
+      return false;
+    RelativeSEMeasurement m(src_id.robot_id, dst_id.robot_id,
+                            src_id.frame_id, dst_id.frame_id,
+                            R, t, kappa, tau);
+    m.weight = weight;
+    m.fixedWeight = fixed_weight;
+    result.measurements.push_back(m);
+  }
+
+  // Trailing data means that the file does not match this format
+  if (in.peek() != std::ifstream::traits_type::eof()) return false;
+
+  checkpoint = std::move(result);
+  return true;
+}
+
+}  // namespace dpgo_ros
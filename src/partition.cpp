@@ -0,0 +1,143 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/partition.h>
+
+#include <algorithm>
+
+namespace dpgo_ros {
+
+namespace {
+
+void computePartitionStatistics(const std::vector<RelativeSEMeasurement> &measurements,
+                                PosePartition &partition) {
+  std::vector<bool> shared(partition.poseIDs.size(), false);
+  partition.numSharedEdges = 0;
+  for (const auto &m : measurements) {
+    if (partition.poseIDs[m.p1].robot_id == partition.poseIDs[m.p2].robot_id) continue;
+    partition.numSharedEdges++;
+    shared[m.p1] = true;
+    shared[m.p2] = true;
+  }
+  partition.numSharedPoses = std::count(shared.begin(), shared.end(), true);
+}
+
+// Number of measurements between each pair of chunks of consecutive poses,
+// summed over the chunk ranges [0, i) x [0, j)
+class ChunkCutCounts {
+ public:
+  ChunkCutCounts(size_t num_poses, size_t num_chunks,
+                 const std::vector<RelativeSEMeasurement> &measurements)
+      : mNumPoses(num_poses), mNumChunks(num_chunks),
+        mPrefix((num_chunks + 1) * (num_chunks + 1), 0) {
+    std::vector<long> counts(num_chunks * num_chunks, 0);
+    for (const auto &m : measurements) {
+      const size_t a = chunk(m.p1);
+      const size_t b = chunk(m.p2);
+      if (a == b) continue;
+      counts[a * num_chunks + b]++;
+      counts[b * num_chunks + a]++;
+    }
+    for (size_t i = 0; i < num_chunks; ++i) {
+      for (size_t j = 0; j < num_chunks; ++j) {
+        prefix(i + 1, j + 1) = counts[i * num_chunks + j] + prefix(i, j + 1) + prefix(i + 1, j) - prefix(i, j);
+      }
+    }
+  }
+
+  // First pose of chunk c
+  size_t start(size_t c) const { return c * mNumPoses / mNumChunks; }
+  size_t chunk(size_t pose) const { return ((pose + 1) * mNumChunks - 1) / mNumPoses; }
+  // Number of measurements between different chunks within chunks [a, b)
+  long internal(size_t a, size_t b) const {
+    return (prefix(b, b) - prefix(a, b) - prefix(b, a) + prefix(a, a)) / 2;
+  }
+
+ private:
+  long &prefix(size_t i, size_t j) { return mPrefix[i * (mNumChunks + 1) + j]; }
+  long prefix(size_t i, size_t j) const { return mPrefix[i * (mNumChunks + 1) + j]; }
+
+  size_t mNumPoses;
+  size_t mNumChunks;
+  std::vector<long> mPrefix;
+};
+
+}  // namespace
+
+PosePartition partitionContiguous(size_t num_poses, unsigned num_robots,
+                                  const std::vector<RelativeSEMeasurement> &measurements) {
+  PosePartition partition;
+  partition.poseIDs.resize(num_poses);
+  const size_t num_poses_per_robot = num_poses / num_robots;
+  for (unsigned robot = 0; robot < num_robots; ++robot) {
+    const size_t start_idx = robot * num_poses_per_robot;
+    size_t end_idx = (robot + 1) * num_poses_per_robot;  // non-inclusive
+    if (robot == num_robots - 1) end_idx = num_poses;
+    for (size_t idx = start_idx; idx < end_idx; ++idx) {
+      partition.poseIDs[idx] = PoseID(robot, idx - start_idx);
+    }
+  }
+  computePartitionStatistics(measurements, partition);
+  return partition;
+}
+
+PosePartition partitionMinEdgeCut(size_t num_poses, unsigned num_robots,
+                                  const std::vector<RelativeSEMeasurement> &measurements,
+                                  const PartitionParameters &params) {
+  const size_t num_chunks = std::min(num_poses, (size_t) num_robots * std::max(1u, params.numChunksPerRobot));
+  if (num_robots <= 1 || num_chunks < num_robots) {
+    return partitionContiguous(num_poses, num_robots, measurements);
+  }
+  const ChunkCutCounts counts(num_poses, num_chunks, measurements);
+  const double average_weight = (double) num_poses / num_robots;
+  const double max_weight = (1 + params.maxImbalance) * average_weight;
+  const double min_weight = (1 - params.maxImbalance) * average_weight;
+
+  // Each robot receives a contiguous range of chunks, so that local pose IDs are consecutive
+  // exactly where the poses are consecutive in the dataset. Minimizing the edge cut is the
+  // same as maximizing the number of measurements within ranges, which dynamic programming
+  // solves exactly over the cut positions: best[k][b] is the largest number of measurements
+  // within the ranges of the first k robots, which cover chunks [0, b).
+  const long infeasible = -1;
+  std::vector<std::vector<long>> best(num_robots + 1, std::vector<long>(num_chunks + 1, infeasible));
+  std::vector<std::vector<size_t>> cut(num_robots + 1, std::vector<size_t>(num_chunks + 1, 0));
+  best[0][0] = 0;
+  for (unsigned k = 1; k <= num_robots; ++k) {
+    for (size_t b = k; b <= num_chunks; ++b) {
+      for (size_t a = k - 1; a < b; ++a) {
+        if (best[k - 1][a] == infeasible) continue;
+        const double weight = counts.start(b) - counts.start(a);
+        if (weight > max_weight || weight < min_weight) continue;
+        const long value = best[k - 1][a] + counts.internal(a, b);
+        if (value > best[k][b]) {
+          best[k][b] = value;
+          cut[k][b] = a;
+        }
+      }
+    }
+  }
+  // Chunks too coarse for the balance constraint
+  if (best[num_robots][num_chunks] == infeasible) {
+    return partitionContiguous(num_poses, num_robots, measurements);
+  }
+
+  PosePartition partition;
+  partition.poseIDs.resize(num_poses);
+  size_t end = num_chunks;
+  for (unsigned k = num_robots; k > 0; --k) {
+    const size_t begin = cut[k][end];
+    const unsigned robot = k - 1;
+    for (size_t idx = counts.start(begin); idx < counts.start(end); ++idx) {
+      partition.poseIDs[idx] = PoseID(robot, idx - counts.start(begin));
+    }
+    end = begin;
+  }
+  computePartitionStatistics(measurements, partition);
+  return partition;
+}
+
+}  // namespace dpgo_ros
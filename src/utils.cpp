@@ -8,9 +8,12 @@
 #include <DPGO/DPGO_types.h>
 #include <DPGO/DPGO_utils.h>
 #include <dpgo_ros/utils.h>
-#include <tf/tf.h>
+#include <Eigen/Eigenvalues>
+#include <Eigen/Geometry>
+#include <algorithm>
 #include <random>
 #include <map>
+#include <unordered_map>
 
 using namespace DPGO;
 using pose_graph_tools::PoseGraphEdge;
@@ -50,59 +53,71 @@ Matrix deserializeMatrix(size_t rows, size_t cols,
 
 MatrixMsg MatrixToMsg(const Matrix &Mat) {
   MatrixMsg msg;
+  MatrixToMsg(Mat, msg);
+  return msg;
+}
+
+void MatrixToMsg(const Matrix &Mat, MatrixMsg &msg) {
   msg.rows = Mat.rows();
   msg.cols = Mat.cols();
-  msg.values = serializeMatrix(msg.rows, msg.cols, Mat);
-  return msg;
+  msg.values.resize(msg.rows * msg.cols);
+  size_t index = 0;
+  for (size_t row = 0; row < msg.rows; ++row) {
+    for (size_t col = 0; col < msg.cols; ++col) {
+      msg.values[index++] = Mat(row, col);
+    }
+  }
 }
 
 Matrix MatrixFromMsg(const MatrixMsg &msg) {
   return deserializeMatrix(msg.rows, msg.cols, msg.values);
 }
 
-Matrix RotationFromPoseMsg(const geometry_msgs::Pose &msg) {
-  // read rotation
-  tf::Quaternion quat;
-  tf::quaternionMsgToTF(msg.orientation, quat);
-  tf::Matrix3x3 rotation(quat);
-  Matrix R(3, 3);
-  R << rotation[0][0], rotation[0][1], rotation[0][2],
-       rotation[1][0], rotation[1][1], rotation[1][2],
-       rotation[2][0], rotation[2][1], rotation[2][2];
+Eigen::Matrix3d RotationFromPoseMsg3d(const geometry_msgs::Pose &msg) {
+  const auto &q = msg.orientation;
+  return Eigen::Quaterniond(q.w, q.x, q.y, q.z).normalized().toRotationMatrix();
+}
+
+Eigen::Vector3d TranslationFromPoseMsg3d(const geometry_msgs::Pose &msg) {
+  return Eigen::Vector3d(msg.position.x, msg.position.y, msg.position.z);
+}
+
+geometry_msgs::Quaternion RotationToQuaternionMsg3d(const Eigen::Matrix3d &R) {
+  const Eigen::Quaterniond q(R);
+  geometry_msgs::Quaternion quat_msg;
+  quat_msg.x = q.x();
+  quat_msg.y = q.y();
+  quat_msg.z = q.z();
+  quat_msg.w = q.w();
+  return quat_msg;
+}
 
-  return R;
+geometry_msgs::Point TranslationToPointMsg3d(const Eigen::Vector3d &t) {
+  geometry_msgs::Point point_msg;
+  point_msg.x = t(0);
+  point_msg.y = t(1);
+  point_msg.z = t(2);
+  return point_msg;
+}
+
+Matrix RotationFromPoseMsg(const geometry_msgs::Pose &msg) {
+  return RotationFromPoseMsg3d(msg);
 }
 
 Matrix TranslationFromPoseMsg(const geometry_msgs::Pose &msg) {
-  tf::Vector3 translation;
-  tf::pointMsgToTF(msg.position, translation);
-  Matrix t(3, 1);
-  t << translation.x(), translation.y(), translation.z();
-  return t;
+  return TranslationFromPoseMsg3d(msg);
 }
 
 geometry_msgs::Quaternion RotationToQuaternionMsg(const Matrix &R) {
   assert(R.rows() == 3);
   assert(R.cols() == 3);
-
-  tf::Matrix3x3 rotation(R(0, 0), R(0, 1), R(0, 2),
-                         R(1, 0), R(1, 1), R(1, 2),
-                         R(2, 0), R(2, 1), R(2, 2));
-  tf::Quaternion quat;
-  rotation.getRotation(quat);
-  geometry_msgs::Quaternion quat_msg;
-  tf::quaternionTFToMsg(quat, quat_msg);
-  return quat_msg;
+  return RotationToQuaternionMsg3d(R);
 }
 
 geometry_msgs::Point TranslationToPointMsg(const Matrix &t) {
   assert(t.rows() == 3);
   assert(t.cols() == 1);
-  // convert translation to ROS message
-  tf::Vector3 translation(t(0), t(1), t(2));
-  geometry_msgs::Point point_msg;
-  tf::pointTFToMsg(translation, point_msg);
-  return point_msg;
+  return TranslationToPointMsg3d(t);
 }
 
 PoseGraphEdge RelativeMeasurementToMsg(const RelativeSEMeasurement &m) {
@@ -116,10 +131,10 @@ PoseGraphEdge RelativeMeasurementToMsg(const RelativeSEMeasurement &m) {
   msg.key_to = m.p2;
 
   // convert rotation to ROS message
-  msg.pose.orientation = RotationToQuaternionMsg(m.R);
+  msg.pose.orientation = RotationToQuaternionMsg3d(m.R);
 
   // convert translation to ROS message
-  msg.pose.position = TranslationToPointMsg(m.t);
+  msg.pose.position = TranslationToPointMsg3d(m.t);
 
   // TODO: write covariance to message
   return msg;
@@ -132,10 +147,10 @@ RelativeSEMeasurement RelativeMeasurementFromMsg(const PoseGraphEdge &msg) {
   size_t p2 = msg.key_to;
 
   // read rotation
-  Matrix R = RotationFromPoseMsg(msg.pose);
+  const Eigen::Matrix3d R = RotationFromPoseMsg3d(msg.pose);
 
   // read translation
-  Matrix t = TranslationFromPoseMsg(msg.pose);
+  const Eigen::Vector3d t = TranslationFromPoseMsg3d(msg.pose);
 
   // TODO: read covariance from message
   double kappa = 10000;
@@ -151,6 +166,35 @@ RelativeSEMeasurement RelativeMeasurementFromMsg(const PoseGraphEdge &msg) {
   return m;
 }
 
+void RelativeMeasurementsToMsg(const std::vector<RelativeSEMeasurement> &measurements,
+                               std::vector<PoseGraphEdge> &edges) {
+  edges.reserve(edges.size() + measurements.size());
+  for (const auto &m : measurements) {
+    edges.push_back(RelativeMeasurementToMsg(m));
+  }
+}
+
+std::vector<RelativeSEMeasurement> RelativeMeasurementsFromMsg(const std::vector<PoseGraphEdge> &edges) {
+  std::vector<RelativeSEMeasurement> measurements;
+  measurements.reserve(edges.size());
+  for (const auto &edge : edges) {
+    measurements.push_back(RelativeMeasurementFromMsg(edge));
+  }
+  return measurements;
+}
+
+std::vector<geometry_msgs::Pose> TrajectoryToPoseMsgs(unsigned n, const Matrix &T) {
+  assert(T.rows() == 3);
+  assert(T.cols() == 4 * n);
+  std::vector<geometry_msgs::Pose> poses(n);
+  for (size_t i = 0; i < n; ++i) {
+    // Fixed-size blocks avoid copying each pose to the heap
+    poses[i].orientation = RotationToQuaternionMsg3d(T.block<3, 3>(0, 4 * i));
+    poses[i].position = TranslationToPointMsg3d(T.block<3, 1>(0, 4 * i + 3));
+  }
+  return poses;
+}
+
 geometry_msgs::PoseArray TrajectoryToPoseArray(unsigned d, unsigned n, const Matrix &T) {
   assert(d == 3);
   assert(T.rows() == d);
@@ -158,19 +202,7 @@ geometry_msgs::PoseArray TrajectoryToPoseArray(unsigned d, unsigned n, const Mat
   geometry_msgs::PoseArray msg;
   msg.header.frame_id = "/world";
   msg.header.stamp = ros::Time::now();
-  for (size_t i = 0; i < n; ++i) {
-    geometry_msgs::Pose pose;
-    Matrix Ri = T.block(0, i * (d + 1), d, d);
-    Matrix ti = T.block(0, i * (d + 1) + d, d, 1);
-
-    // convert rotation to ROS message
-    pose.orientation = RotationToQuaternionMsg(Ri);
-
-    // convert translation to ROS message
-    pose.position = TranslationToPointMsg(ti);
-
-    msg.poses.push_back(pose);
-  }
+  msg.poses = TrajectoryToPoseMsgs(n, T);
   return msg;
 }
 
@@ -181,23 +213,13 @@ nav_msgs::Path TrajectoryToPath(unsigned d, unsigned n, const Matrix &T) {
   nav_msgs::Path msg;
   msg.header.frame_id = "/world";
   msg.header.stamp = ros::Time::now();
+  const auto poses = TrajectoryToPoseMsgs(n, T);
+  msg.poses.resize(n);
   for (size_t i = 0; i < n; ++i) {
-    geometry_msgs::Pose pose;
-    Matrix Ri = T.block(0, i * (d + 1), d, d);
-    Matrix ti = T.block(0, i * (d + 1) + d, d, 1);
-
-    // convert rotation to ROS message
-    pose.orientation = RotationToQuaternionMsg(Ri);
-
-    // convert translation to ROS message
-    pose.position = TranslationToPointMsg(ti);
-
-    geometry_msgs::PoseStamped poseStamped;
+    auto &poseStamped = msg.poses[i];
     poseStamped.header.frame_id = "/world";
-    poseStamped.header.stamp = ros::Time::now();
-    poseStamped.pose = pose;
-
-    msg.poses.push_back(poseStamped);
+    poseStamped.header.stamp = msg.header.stamp;
+    poseStamped.pose = poses[i];
   }
   return msg;
 }
@@ -209,13 +231,12 @@ sensor_msgs::PointCloud TrajectoryToPointCloud(unsigned d, unsigned n, const Mat
   sensor_msgs::PointCloud msg;
   msg.header.frame_id = "/world";
   msg.header.stamp = ros::Time::now();
+  msg.points.resize(n);
   for (size_t i = 0; i < n; ++i) {
-    geometry_msgs::Point32 point;
-    Matrix ti = T.block(0, i * (d + 1) + d, d, 1);
-    point.x = ti(0);
-    point.y = ti(1);
-    point.z = ti(2);
-    msg.points.push_back(point);
+    auto &point = msg.points[i];
+    point.x = T(0, 4 * i + 3);
+    point.y = T(1, 4 * i + 3);
+    point.z = T(2, 4 * i + 3);
   }
   return msg;
 }
@@ -227,23 +248,15 @@ pose_graph_tools::PoseGraph TrajectoryToPoseGraphMsg(unsigned robotID, unsigned
   pose_graph_tools::PoseGraph pose_graph_msg;
   pose_graph_msg.header.frame_id = "/world";
   pose_graph_msg.header.stamp = ros::Time::now();
+  const auto poses = TrajectoryToPoseMsgs(n, T);
+  pose_graph_msg.nodes.resize(n);
   for (size_t i = 0; i < n; ++i) {
-    pose_graph_tools::PoseGraphNode node_msg;
+    auto &node_msg = pose_graph_msg.nodes[i];
     node_msg.robot_id = robotID;
     node_msg.key = i;
     node_msg.header.frame_id = "/world";
     node_msg.header.stamp = pose_graph_msg.header.stamp;
-
-    Matrix Ri = T.block(0, i * (d + 1), d, d);
-    Matrix ti = T.block(0, i * (d + 1) + d, d, 1);
-
-    // convert rotation to ROS message
-    node_msg.pose.orientation = RotationToQuaternionMsg(Ri);
-
-    // convert translation to ROS message
-    node_msg.pose.position = TranslationToPointMsg(ti);
-
-    pose_graph_msg.nodes.push_back(node_msg);
+    node_msg.pose = poses[i];
   }
   return pose_graph_msg;
 }
@@ -280,17 +293,140 @@ PGOAgentStatus statusFromMsg(const Status &msg) {
   return status;
 }
 
-void randomSleep(double min_sec, double max_sec) {
+PoseGraphSummary summarizePoseGraph(const pose_graph_tools::PoseGraph &pose_graph, unsigned robot_id) {
+  PoseGraphSummary summary;
+  summary.numEdges = pose_graph.edges.size();
+  for (const auto &edge : pose_graph.edges) {
+    if (edge.robot_from == edge.robot_to) {
+      if (edge.key_to != edge.key_from + 1) summary.numLoopClosures++;
+    } else if (robot_id == std::min(edge.robot_from, edge.robot_to)) {
+      summary.numLoopClosures++;
+    }
+  }
+  return summary;
+}
+
+void extendTrajectoryByOdometry(LiftedPoseArray &X, unsigned n,
+                                const std::vector<RelativeSEMeasurement> &odometry) {
+  const unsigned n_old = X.n();
+  if (n <= n_old || n_old == 0) return;
+  std::map<size_t, const RelativeSEMeasurement *> incoming_odometry;
+  for (const auto &m : odometry) {
+    if (m.p2 >= n_old && m.p1 + 1 == m.p2) incoming_odometry[m.p2] = &m;
+  }
+  const unsigned r = X.r();
+  const unsigned d = X.d();
+  Matrix data = Matrix::Zero(r, (d + 1) * n);
+  data.leftCols((d + 1) * n_old) = X.getData();
+  LiftedPoseArray XNew(r, d, n);
+  XNew.setData(data);
+  for (unsigned k = n_old; k < n; ++k) {
+    const auto it = incoming_odometry.find(k);
+    if (it == incoming_odometry.end()) {
+      XNew.pose(k) = XNew.pose(k - 1);
+      continue;
+    }
+    const Matrix Y = XNew.rotation(k - 1);
+    const Matrix p = XNew.translation(k - 1);
+    XNew.rotation(k) = Y * it->second->R;
+    XNew.translation(k) = p + Y * it->second->t;
+  }
+  X = XNew;
+}
+
+Matrix liftedRotationGram(const LiftedPoseArray &X) {
+  Matrix gram = Matrix::Zero(X.r(), X.r());
+  for (unsigned i = 0; i < X.n(); ++i) {
+    const Matrix Y = X.rotation(i);
+    gram.noalias() += Y * Y.transpose();
+  }
+  return gram;
+}
+
+double liftedRankRatio(const Matrix &gram, unsigned d) {
+  const unsigned r = gram.rows();
+  if (r <= d) return 0;
+  Eigen::SelfAdjointEigenSolver<Matrix> solver(gram, Eigen::EigenvaluesOnly);
+  // Eigenvalues are sorted in increasing order
+  const Vector &eigenvalues = solver.eigenvalues();
+  const double max_eigenvalue = eigenvalues(r - 1);
+  if (max_eigenvalue <= 0) return 0;
+  return std::max(0.0, eigenvalues(r - 1 - d)) / max_eigenvalue;
+}
+
+std::vector<double> loadBalancedUpdateWeights(const std::vector<RobotUpdateStatistics> &stats,
+                                              double min_weight_ratio) {
+  const size_t num_robots = stats.size();
+  std::vector<double> weights(num_robots, -1);
+  double max_weight = 0;
+  for (size_t i = 0; i < num_robots; ++i) {
+    if (!stats[i].valid) continue;
+    const double recovered = std::min(1.0, (double) stats[i].staleness / num_robots);
+    const double expected_decrease = std::max(0.0, stats[i].costDecrease) * recovered;
+    weights[i] = expected_decrease / std::max(stats[i].elapsedMs, 1.0);
+    max_weight = std::max(max_weight, weights[i]);
+  }
+  if (max_weight <= 0) return std::vector<double>(num_robots, 1.0);
+  for (auto &weight : weights) {
+    // Explore robots without statistics
+    if (weight < 0) weight = max_weight;
+    weight = std::max(weight, min_weight_ratio * max_weight);
+  }
+  return weights;
+}
+
+MeasurementChanges compareMeasurements(const std::vector<RelativeSEMeasurement> &previous,
+                                       const std::vector<RelativeSEMeasurement> &current) {
+  std::unordered_map<EdgeID, const RelativeSEMeasurement *, HashEdgeID> previous_map;
+  previous_map.reserve(previous.size());
+  for (const auto &m : previous) {
+    previous_map[EdgeID(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2))] = &m;
+  }
+  MeasurementChanges changes;
+  size_t num_matched = 0;
+  for (const auto &m : current) {
+    const auto it = previous_map.find(EdgeID(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2)));
+    if (it == previous_map.end()) {
+      changes.numAdded++;
+      continue;
+    }
+    num_matched++;
+    const RelativeSEMeasurement &m_prev = *it->second;
+    if (m.weight != m_prev.weight || m.fixedWeight != m_prev.fixedWeight ||
+        m.kappa != m_prev.kappa || m.tau != m_prev.tau || m.R != m_prev.R || m.t != m_prev.t) {
+      changes.numModified++;
+    }
+  }
+  changes.numRemoved = previous_map.size() - num_matched;
+  return changes;
+}
+
+unsigned leaderSuccessor(unsigned leader_id, const std::vector<bool> &active_robots) {
+  for (unsigned robot_id = 0; robot_id < active_robots.size(); ++robot_id) {
+    if (robot_id != leader_id && active_robots[robot_id]) {
+      return robot_id;
+    }
+  }
+  return active_robots.size();
+}
+
+bool followLeaderTakeover(unsigned new_leader, unsigned command_cluster_id,
+                          unsigned &leader_id, std::vector<bool> &active_robots) {
+  if (command_cluster_id != new_leader || new_leader != leaderSuccessor(leader_id, active_robots)) {
+    return false;
+  }
+  if (leader_id < active_robots.size()) active_robots[leader_id] = false;
+  leader_id = new_leader;
+  return true;
+}
+
+ros::Duration randomDuration(double min_sec, double max_sec) {
   CHECK(min_sec < max_sec);
   CHECK(min_sec > 0);
-  if (max_sec < 1e-3)
-    return;
   std::random_device rd;
   std::mt19937 gen(rd());
   std::uniform_real_distribution<double> distribution(min_sec, max_sec);
-  double sleep_time = distribution(gen);
-  ROS_INFO("Sleep %f sec...", sleep_time);
-  ros::Duration(sleep_time).sleep();
+  return ros::Duration(distribution(gen));
 }
 
 }  // namespace dpgo_ros
\ No newline at end of file
@@ -0,0 +1,189 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <dpgo_ros/chain_reduction.h>
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+namespace {
+
+// Helix trajectory of robot 0 with noise-free odometry
+PoseArray makeTrajectory(unsigned n) {
+  PoseArray T(3, n);
+  for (unsigned i = 0; i < n; ++i) {
+    const double angle = 0.1 * i;
+    T.rotation(i) = Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+    T.translation(i) = Eigen::Vector3d(5 * std::cos(angle), 5 * std::sin(angle), 0.05 * i);
+  }
+  return T;
+}
+
+RelativeSEMeasurement makeMeasurement(const PoseArray &T, unsigned r1, unsigned p1, unsigned r2, unsigned p2,
+                                      const Matrix &T2_rotation, const Matrix &T2_translation) {
+  const Matrix R = T.rotation(p1).transpose() * T2_rotation;
+  const Matrix t = T.rotation(p1).transpose() * (T2_translation - T.translation(p1));
+  return RelativeSEMeasurement(r1, r2, p1, p2, R, t, 1e4, 1e2);
+}
+
+}  // namespace
+
+TEST(ChainReductionTest, ReduceAndExpand) {
+  const unsigned n = 100;
+  const PoseArray T = makeTrajectory(n);
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    measurements.push_back(makeMeasurement(T, 0, i, 0, i + 1, T.rotation(i + 1), T.translation(i + 1)));
+  }
+  // Private loop closure and shared loop closure with pose 7 of robot 1
+  measurements.push_back(makeMeasurement(T, 0, 13, 0, 77, T.rotation(77), T.translation(77)));
+  RelativeSEMeasurement shared(1, 0, 7, 42, Matrix::Identity(3, 3), Matrix::Zero(3, 1), 1e4, 1e2);
+  measurements.push_back(shared);
+
+  ChainReduction reduction;
+  const auto reduced = reduceOdometryChains(0, measurements, 25, reduction);
+  // Poses 0, 25, 50, 75, 99, and the loop closure endpoints 13, 42, 77
+  ASSERT_EQ(reduction.numPoses(), n);
+  ASSERT_EQ(reduction.numKeptPoses(), 8u);
+  ASSERT_EQ(reduction.reducedIndex(13), 1);
+  ASSERT_EQ(reduction.reducedIndex(14), -1);
+  ASSERT_EQ(reduction.fullIndex(3), 42u);
+  ASSERT_EQ(reduced.size(), 7u + 2u);
+
+  PoseArray TReduced(3, reduction.numKeptPoses());
+  for (unsigned k = 0; k < reduction.numKeptPoses(); ++k) {
+    TReduced.pose(k) = T.pose(reduction.fullIndex(k));
+  }
+  for (const auto &m : reduced) {
+    if (m.r1 == 0 && m.r2 == 0) {
+      ASSERT_LT(m.p2, reduction.numKeptPoses());
+      // Composed measurements are consistent with the trajectory
+      const Matrix R = TReduced.rotation(m.p1).transpose() * TReduced.rotation(m.p2);
+      const Matrix t = TReduced.rotation(m.p1).transpose() * (TReduced.translation(m.p2) - TReduced.translation(m.p1));
+      ASSERT_LE((m.R - R).norm(), 1e-9);
+      ASSERT_LE((m.t - t).norm(), 1e-9);
+      if (m.p1 + 1 == m.p2) {
+        ASSERT_TRUE(m.fixedWeight);
+        ASSERT_LT(m.kappa, 1e4);
+        ASSERT_LT(m.tau, 1e2);
+      }
+    } else {
+      // Indices of the other robot are unchanged
+      ASSERT_EQ(m.r1, 1u);
+      ASSERT_EQ(m.p1, 7u);
+      ASSERT_EQ(m.p2, 3u);
+    }
+  }
+
+  // Expanding the exact reduced trajectory recovers the full trajectory
+  PoseArray TFull = expandTrajectory(reduction, TReduced);
+  ASSERT_LE((TFull.getData() - T.getData()).norm(), 1e-9);
+
+  // A perturbed kept pose is matched exactly, and the chains before it stay continuous
+  TReduced.translation(4) += Eigen::Vector3d(0.3, -0.2, 0.1);
+  TReduced.rotation(4) = TReduced.rotation(4) * Eigen::AngleAxisd(0.05, Eigen::Vector3d::UnitX()).toRotationMatrix();
+  TFull = expandTrajectory(reduction, TReduced);
+  ASSERT_LE((TFull.pose(reduction.fullIndex(4)) - TReduced.pose(4)).norm(), 1e-9);
+  ASSERT_LE((TFull.pose(reduction.fullIndex(3)) - TReduced.pose(3)).norm(), 1e-9);
+  for (unsigned i = reduction.fullIndex(3); i < reduction.fullIndex(4); ++i) {
+    ASSERT_LE((TFull.translation(i + 1) - TFull.translation(i)).norm(), 0.6);
+  }
+}
+
+TEST(ChainReductionTest, MissingOdometry) {
+  const unsigned n = 20;
+  const PoseArray T = makeTrajectory(n);
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    if (i == 9) continue;
+    measurements.push_back(makeMeasurement(T, 0, i, 0, i + 1, T.rotation(i + 1), T.translation(i + 1)));
+  }
+  ChainReduction reduction;
+  const auto reduced = reduceOdometryChains(0, measurements, 0, reduction);
+  // Poses 0, 9, 10, 19
+  ASSERT_EQ(reduction.numKeptPoses(), 4u);
+  ASSERT_EQ(reduction.fullIndex(1), 9u);
+  ASSERT_EQ(reduction.fullIndex(2), 10u);
+  // No composed measurement across the missing odometry
+  ASSERT_EQ(reduced.size(), 2u);
+}
+TEST(ChainReductionTest, LoopClosureBetweenKeyframes) {
+  const unsigned n = 30;
+  const PoseArray T = makeTrajectory(n);
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    measurements.push_back(makeMeasurement(T, 0, i, 0, i + 1, T.rotation(i + 1), T.translation(i + 1)));
+  }
+  // Loop closure between two consecutive keyframes
+  measurements.push_back(makeMeasurement(T, 0, 10, 0, 20, T.rotation(20), T.translation(20)));
+
+  ChainReduction reduction;
+  const auto reduced = reduceOdometryChains(0, measurements, 10, reduction);
+  // Poses 0, 10, 20, 29, and pose 15 between the loop closure endpoints
+  ASSERT_EQ(reduction.numKeptPoses(), 5u);
+  ASSERT_EQ(reduction.reducedIndex(15), 2);
+  // Every pair of robot poses appears in one measurement only
+  std::set<std::pair<size_t, size_t>> edges;
+  for (const auto &m : reduced) {
+    ASSERT_TRUE(edges.emplace(m.p1, m.p2).second);
+    if (m.p1 + 1 == m.p2) {
+      ASSERT_TRUE(m.fixedWeight);
+    }
+  }
+  ASSERT_EQ(reduced.size(), 4u + 1u);
+}
+
+TEST(ChainReductionTest, MeasurementRoundTrip) {
+  const unsigned n = 60;
+  const PoseArray T = makeTrajectory(n);
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    measurements.push_back(makeMeasurement(T, 0, i, 0, i + 1, T.rotation(i + 1), T.translation(i + 1)));
+  }
+  measurements.push_back(makeMeasurement(T, 0, 12, 0, 47, T.rotation(47), T.translation(47)));
+  measurements.push_back(RelativeSEMeasurement(0, 1, 33, 5, Matrix::Identity(3, 3), Matrix::Zero(3, 1), 1e4, 1e2));
+
+  ChainReduction reduction;
+  auto reduced = reduceOdometryChains(0, measurements, 20, reduction);
+  // Weights of the loop closures in the reduced graph, saved with full indices
+  std::vector<RelativeSEMeasurement> saved;
+  for (auto &m : reduced) {
+    if (m.fixedWeight) continue;
+    m.weight = m.r2 == 1 ? 0.25 : 0.75;
+    saved.push_back(expandMeasurement(0, reduction, m));
+  }
+  ASSERT_EQ(saved.size(), 2u);
+  ASSERT_EQ(saved[0].p1, 12u);
+  ASSERT_EQ(saved[0].p2, 47u);
+  ASSERT_EQ(saved[1].p1, 33u);
+  ASSERT_EQ(saved[1].p2, 5u);
+
+  // A new loop closure before the saved ones shifts their reduced indices
+  measurements.push_back(makeMeasurement(T, 0, 3, 0, 8, T.rotation(8), T.translation(8)));
+  ChainReduction new_reduction;
+  const auto new_reduced = reduceOdometryChains(0, measurements, 20, new_reduction);
+  ASSERT_NE(new_reduction.reducedIndex(12), reduction.reducedIndex(12));
+  for (const auto &m : saved) {
+    RelativeSEMeasurement reduced_m = m;
+    ASSERT_TRUE(reduceMeasurement(0, new_reduction, reduced_m));
+    const auto it = std::find_if(new_reduced.begin(), new_reduced.end(), [&](const RelativeSEMeasurement &e) {
+      return e.r1 == reduced_m.r1 && e.p1 == reduced_m.p1 && e.r2 == reduced_m.r2 && e.p2 == reduced_m.p2;
+    });
+    ASSERT_TRUE(it != new_reduced.end());
+    ASSERT_EQ(expandMeasurement(0, new_reduction, *it).p1, m.p1);
+    ASSERT_EQ(expandMeasurement(0, new_reduction, *it).p2, m.p2);
+  }
+
+  // Removed poses cannot be mapped to the reduced graph
+  RelativeSEMeasurement removed = measurements[14];
+  ASSERT_FALSE(reduceMeasurement(0, new_reduction, removed));
+}
@@ -0,0 +1,140 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+#include <dpgo_ros/checkpoint.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+TEST(CheckpointTest, RoundTrip) {
+  const unsigned d = 3;
+  const unsigned n = 4;
+  AgentCheckpoint checkpoint;
+  checkpoint.robot_id = 1;
+  checkpoint.d = d;
+  checkpoint.r = 5;
+  checkpoint.poses.emplace(d, n);
+  checkpoint.poses->setData(Matrix::Random(d, (d + 1) * n));
+  checkpoint.lifting_matrix.emplace(Matrix::Random(5, d));
+  Pose T(d);
+  T.setData(Matrix::Random(d, d + 1));
+  checkpoint.neighbor_poses[PoseID(0, 7)] = T;
+  checkpoint.edge_weights[EdgeID(PoseID(0, 7), PoseID(1, 2))] = 0.25;
+  RelativeSEMeasurement m(0, 1, 7, 2, Matrix::Identity(d, d), Matrix::Ones(d, 1), 10.0, 100.0);
+  m.weight = 0;
+  m.fixedWeight = true;
+  checkpoint.measurements.push_back(m);
+
+  const std::string path = "/tmp/dpgo_ros_test_checkpoint.bin";
+  ASSERT_TRUE(writeCheckpoint(path, checkpoint));
+
+  AgentCheckpoint loaded;
+  ASSERT_TRUE(readCheckpoint(path, loaded));
+  ASSERT_EQ(loaded.robot_id, 1u);
+  ASSERT_EQ(loaded.d, d);
+  ASSERT_EQ(loaded.r, 5u);
+  ASSERT_TRUE(loaded.poses.has_value());
+  ASSERT_EQ(loaded.poses->n(), n);
+  ASSERT_LE((loaded.poses->getData() - checkpoint.poses->getData()).norm(), 1e-12);
+  ASSERT_TRUE(loaded.lifting_matrix.has_value());
+  ASSERT_LE((loaded.lifting_matrix.value() - checkpoint.lifting_matrix.value()).norm(), 1e-12);
+  ASSERT_EQ(loaded.neighbor_poses.size(), 1u);
+  ASSERT_LE((loaded.neighbor_poses.at(PoseID(0, 7)).getData() - T.getData()).norm(), 1e-12);
+  ASSERT_EQ(loaded.edge_weights.size(), 1u);
+  ASSERT_EQ(loaded.edge_weights.at(EdgeID(PoseID(0, 7), PoseID(1, 2))), 0.25);
+  ASSERT_EQ(loaded.measurements.size(), 1u);
+  const auto &m_loaded = loaded.measurements[0];
+  ASSERT_EQ(m_loaded.r1, 0u);
+  ASSERT_EQ(m_loaded.p1, 7u);
+  ASSERT_EQ(m_loaded.r2, 1u);
+  ASSERT_EQ(m_loaded.p2, 2u);
+  ASSERT_LE((m_loaded.t - m.t).norm(), 1e-12);
+  ASSERT_EQ(m_loaded.kappa, 10.0);
+  ASSERT_EQ(m_loaded.tau, 100.0);
+  ASSERT_EQ(m_loaded.weight, 0);
+  ASSERT_TRUE(m_loaded.fixedWeight);
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointTest, RejectTruncatedFile) {
+  AgentCheckpoint checkpoint;
+  checkpoint.robot_id = 0;
+  checkpoint.d = 2;
+  checkpoint.r = 2;
+  checkpoint.poses.emplace(2, 10);
+  checkpoint.poses->setData(Matrix::Random(2, 30));
+  const std::string path = "/tmp/dpgo_ros_test_checkpoint_truncated.bin";
+  ASSERT_TRUE(writeCheckpoint(path, checkpoint));
+
+  // Truncate the file in the middle of the trajectory
+  std::ifstream in(path, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  in.close();
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), content.size() / 2);
+  out.close();
+
+  AgentCheckpoint loaded;
+  ASSERT_FALSE(readCheckpoint(path, loaded));
+  ASSERT_FALSE(readCheckpoint("/tmp/dpgo_ros_missing_checkpoint.bin", loaded));
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointTest, RejectInconsistentSizes) {
+  AgentCheckpoint checkpoint;
+  checkpoint.robot_id = 0;
+  checkpoint.d = 2;
+  checkpoint.r = 2;
+  checkpoint.poses.emplace(2, 10);
+  checkpoint.poses->setData(Matrix::Random(2, 30));
+  const std::string path = "/tmp/dpgo_ros_test_checkpoint_corrupt.bin";
+  ASSERT_TRUE(writeCheckpoint(path, checkpoint));
+  std::ifstream in(path, std::ios::binary);
+  const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  in.close();
+  auto write_file = [&](const std::string &data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+  };
+  // Number of poses (after magic, version, robot ID, d, r and the has_value flag)
+  const size_t n_offset = 5 * sizeof(uint32_t) + sizeof(uint8_t);
+  AgentCheckpoint loaded;
+
+  // Huge trajectory that is consistent with the stored matrix size, but not with the file size
+  std::string corrupt = content;
+  const uint32_t n = 1u << 28;
+  const uint32_t cols = 3 * n;
+  corrupt.replace(n_offset, sizeof(uint32_t), reinterpret_cast<const char *>(&n), sizeof(uint32_t));
+  corrupt.replace(n_offset + 2 * sizeof(uint32_t), sizeof(uint32_t),
+                  reinterpret_cast<const char *>(&cols), sizeof(uint32_t));
+  write_file(corrupt);
+  ASSERT_FALSE(readCheckpoint(path, loaded));
+
+  // Matrix size does not match the number of poses
+  corrupt = content;
+  corrupt.replace(n_offset, sizeof(uint32_t), reinterpret_cast<const char *>(&cols), sizeof(uint32_t));
+  write_file(corrupt);
+  ASSERT_FALSE(readCheckpoint(path, loaded));
+
+  // Trailing data
+  write_file(content + "x");
+  ASSERT_FALSE(readCheckpoint(path, loaded));
+
+  write_file(content);
+  ASSERT_TRUE(readCheckpoint(path, loaded));
+  std::remove(path.c_str());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
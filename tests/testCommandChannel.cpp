@@ -0,0 +1,195 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <dpgo_ros/CommandChannel.h>
+#include <dpgo_ros/InMemoryTransport.h>
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+namespace {
+
+// Agent on an InMemoryBus that acknowledges every received command in a status message
+struct Agent {
+  Agent(InMemoryBus &bus, unsigned robot_id, unsigned num_robots, uint32_t epoch)
+      : id(robot_id), transport(bus, robot_id), channel(robot_id, num_robots, epoch, transport) {}
+
+  void subscribe(unsigned robot_id) {
+    PGOAgentMessageHandlers handlers;
+    handlers.command = [this](const CommandConstPtr &msg) {
+      if (num_dropped_commands > 0) {
+        num_dropped_commands--;
+        return;
+      }
+      if (channel.receive(*msg)) received.push_back(msg->command);
+      publishStatus();
+    };
+    handlers.status = [this](const StatusConstPtr &msg) { channel.acknowledge(*msg); };
+    transport.subscribe(robot_id, handlers);
+  }
+
+  void publishStatus() {
+    StatusPtr msg = boost::make_shared<Status>();
+    msg->robot_id = id;
+    channel.fillAcknowledgements(*msg);
+    transport.publishStatus(msg);
+  }
+
+  unsigned id;
+  InMemoryTransport transport;
+  CommandChannel channel;
+  // Types of the commands received without duplicates
+  std::vector<uint8_t> received;
+  // Number of the next commands that are lost
+  unsigned num_dropped_commands = 0;
+};
+
+std::vector<std::unique_ptr<Agent>> makeTeam(InMemoryBus &bus, unsigned num_robots) {
+  std::vector<std::unique_ptr<Agent>> agents;
+  for (unsigned robot_id = 0; robot_id < num_robots; ++robot_id) {
+    agents.push_back(std::make_unique<Agent>(bus, robot_id, num_robots, 10 + robot_id));
+  }
+  for (auto &agent : agents) {
+    for (unsigned robot_id = 0; robot_id < num_robots; ++robot_id) {
+      if (robot_id != agent->id) agent->subscribe(robot_id);
+    }
+  }
+  return agents;
+}
+
+CommandPtr makeCommand(uint8_t type) {
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->publishing_robot = 0;
+  msg->command = type;
+  return msg;
+}
+
+bool allActive(unsigned robot_id) { return true; }
+
+}  // namespace
+
+TEST(CommandChannelTest, SequenceWindow) {
+  CommandSequenceWindow window;
+  const uint32_t epoch = 7;
+  ASSERT_TRUE(window.receive(epoch, 1));
+  ASSERT_FALSE(window.receive(epoch, 1));
+  // Sequence number 3 is lost and arrives later
+  ASSERT_TRUE(window.receive(epoch, 2));
+  ASSERT_TRUE(window.receive(epoch, 4));
+  ASSERT_TRUE(CommandSequenceWindow::acknowledges(window.highest(), window.mask(), 4));
+  ASSERT_TRUE(CommandSequenceWindow::acknowledges(window.highest(), window.mask(), 1));
+  ASSERT_FALSE(CommandSequenceWindow::acknowledges(window.highest(), window.mask(), 3));
+  ASSERT_FALSE(CommandSequenceWindow::acknowledges(window.highest(), window.mask(), 5));
+  ASSERT_TRUE(window.receive(epoch, 3));
+  ASSERT_FALSE(window.receive(epoch, 3));
+  ASSERT_TRUE(CommandSequenceWindow::acknowledges(window.highest(), window.mask(), 3));
+  ASSERT_EQ(window.highest(), 4u);
+
+  // Commands without acknowledgement are never duplicates
+  ASSERT_TRUE(window.receive(epoch, 0));
+  ASSERT_TRUE(window.receive(epoch, 0));
+
+  // Sequence numbers that leave the window are no longer acknowledged, and late copies are dropped
+  ASSERT_TRUE(window.receive(epoch, 4 + CommandSequenceWindow::kWindowSize));
+  ASSERT_TRUE(CommandSequenceWindow::acknowledges(window.highest(), window.mask(), 4));
+  ASSERT_FALSE(CommandSequenceWindow::acknowledges(window.highest(), window.mask(), 3));
+  ASSERT_FALSE(window.receive(epoch, 2));
+
+  // Publisher restarted after a few commands, before its sequence numbers left the window
+  ASSERT_TRUE(window.receive(epoch + 1, 3));
+  ASSERT_EQ(window.epoch(), epoch + 1);
+  ASSERT_EQ(window.highest(), 3u);
+  ASSERT_FALSE(window.receive(epoch + 1, 3));
+  ASSERT_TRUE(window.receive(epoch + 1, 1));
+}
+
+TEST(CommandChannelTest, RetransmitUntilAcknowledged) {
+  InMemoryBus bus;
+  auto agents = makeTeam(bus, 3);
+  const std::vector<unsigned> team{0, 1, 2};
+
+  // The first transmission to robot 2 is lost
+  agents[2]->num_dropped_commands = 1;
+  agents[0]->channel.publish(makeCommand(Command::INITIALIZE), team, 0);
+  ASSERT_EQ(agents[0]->channel.numPendingCommands(), 1u);
+  bus.spinOnce();
+  bus.spinOnce();
+  ASSERT_EQ(agents[1]->received.size(), 1u);
+  ASSERT_TRUE(agents[2]->received.empty());
+  ASSERT_EQ(agents[0]->channel.numPendingCommands(), 1u);
+
+  // Nothing is retransmitted before the timeout
+  ASSERT_TRUE(agents[0]->channel.retransmit(0.05, 0.1, 3, allActive).empty());
+  const auto retransmissions = agents[0]->channel.retransmit(0.2, 0.1, 3, allActive);
+  ASSERT_EQ(retransmissions.size(), 1u);
+  ASSERT_EQ(retransmissions[0].num_retransmissions, 1u);
+  ASSERT_EQ(retransmissions[0].num_unacked_robots, 1u);
+  ASSERT_FALSE(retransmissions[0].abandoned);
+  bus.spinOnce();
+  bus.spinOnce();
+
+  // Robot 1 drops the duplicate, and robot 2 acknowledges the retransmission
+  const std::vector<uint8_t> expected{Command::INITIALIZE};
+  ASSERT_EQ(agents[1]->received, expected);
+  ASSERT_EQ(agents[2]->received, expected);
+  ASSERT_EQ(agents[0]->channel.numPendingCommands(), 0u);
+  ASSERT_TRUE(agents[0]->channel.retransmit(0.4, 0.1, 3, allActive).empty());
+}
+
+TEST(CommandChannelTest, AbandonAndDeactivate) {
+  InMemoryBus bus;
+  auto agents = makeTeam(bus, 3);
+  const std::vector<unsigned> team{0, 1, 2};
+
+  // Robot 2 loses every command
+  agents[2]->num_dropped_commands = 100;
+  agents[0]->channel.publish(makeCommand(Command::UPDATE), team, 0);
+  agents[0]->channel.publish(makeCommand(Command::UPDATE_WEIGHT), team, 0);
+  bus.spinOnce();
+  bus.spinOnce();
+  ASSERT_EQ(agents[1]->received.size(), 2u);
+  ASSERT_EQ(agents[0]->channel.retransmit(0.2, 0.1, 1, allActive).size(), 2u);
+  const auto abandoned = agents[0]->channel.retransmit(0.4, 0.1, 1, allActive);
+  ASSERT_EQ(abandoned.size(), 2u);
+  ASSERT_TRUE(abandoned[0].abandoned);
+  ASSERT_EQ(abandoned[0].msg->command, Command::UPDATE);
+  ASSERT_EQ(agents[0]->channel.numPendingCommands(), 0u);
+
+  // Robots that are no longer active do not need to acknowledge
+  agents[0]->channel.publish(makeCommand(Command::TERMINATE), team, 1);
+  bus.spinOnce();
+  bus.spinOnce();
+  const auto retransmissions = agents[0]->channel.retransmit(
+      1.5, 0.1, 1, [](unsigned robot_id) { return robot_id != 2; });
+  ASSERT_TRUE(retransmissions.empty());
+  ASSERT_EQ(agents[0]->channel.numPendingCommands(), 0u);
+}
+
+TEST(CommandChannelTest, PublisherRestart) {
+  InMemoryBus bus;
+  auto agents = makeTeam(bus, 2);
+  const std::vector<unsigned> team{0, 1};
+
+  agents[0]->channel.publish(makeCommand(Command::INITIALIZE), team, 0);
+  bus.spinOnce();
+  bus.spinOnce();
+  ASSERT_EQ(agents[0]->channel.numPendingCommands(), 0u);
+
+  // After a restart, robot 0 starts over with sequence number 1 in a new epoch
+  CommandChannel restarted(0, 2, 99, agents[0]->transport);
+  PGOAgentMessageHandlers handlers;
+  handlers.status = [&restarted](const StatusConstPtr &msg) { restarted.acknowledge(*msg); };
+  agents[0]->transport.subscribe(1, handlers);
+  restarted.publish(makeCommand(Command::INITIALIZE), team, 10);
+  bus.spinOnce();
+  bus.spinOnce();
+  ASSERT_EQ(agents[1]->received.size(), 2u);
+  ASSERT_EQ(restarted.numPendingCommands(), 0u);
+}
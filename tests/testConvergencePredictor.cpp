@@ -0,0 +1,58 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <dpgo_ros/ConvergencePredictor.h>
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+TEST(ConvergencePredictorTest, LinearConvergence) {
+  const double rate = 0.9;
+  ConvergencePredictor predictor(5);
+  ASSERT_FALSE(predictor.convergenceRate());
+  // Cost f_k = 100 * rate^k
+  double cost = 100;
+  for (unsigned k = 1; k <= 40; ++k) {
+    const double next_cost = 100 * std::pow(rate, k);
+    predictor.addCostDecrease(k, cost - next_cost);
+    cost = next_cost;
+  }
+  ASSERT_TRUE(predictor.convergenceRate());
+  ASSERT_NEAR(predictor.convergenceRate().value(), rate, 1e-9);
+  ASSERT_NEAR(predictor.predictedRemainingDecrease(), cost, 1e-6);
+  ASSERT_NEAR(predictor.totalDecrease(), 100 - cost, 1e-9);
+  ASSERT_FALSE(predictor.converged(1e-3));
+  ASSERT_TRUE(predictor.converged(0.02));
+
+  // Duplicated reports are ignored
+  predictor.addCostDecrease(40, 1e3);
+  ASSERT_NEAR(predictor.totalDecrease(), 100 - cost, 1e-9);
+
+  predictor.reset();
+  ASSERT_FALSE(predictor.convergenceRate());
+  ASSERT_FALSE(predictor.converged(1));
+}
+
+TEST(ConvergencePredictorTest, MissingIterations) {
+  ConvergencePredictor predictor(4);
+  // Only every other iteration is reported, and the cost stops decreasing
+  for (unsigned k = 2; k <= 20; k += 2) {
+    predictor.addCostDecrease(k, k <= 10 ? 1.0 : 0.0);
+  }
+  ASSERT_TRUE(predictor.convergenceRate());
+  ASSERT_DOUBLE_EQ(predictor.convergenceRate().value(), 0);
+  ASSERT_DOUBLE_EQ(predictor.predictedRemainingDecrease(), 0);
+  ASSERT_TRUE(predictor.converged(1e-6));
+
+  // Increasing decreases cannot be extrapolated
+  ConvergencePredictor diverging(4);
+  for (unsigned k = 1; k <= 20; ++k) diverging.addCostDecrease(k, k);
+  ASSERT_TRUE(std::isinf(diverging.predictedRemainingDecrease()));
+  ASSERT_FALSE(diverging.converged(1));
+}
@@ -0,0 +1,78 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <dpgo_ros/FailureDetector.h>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+TEST(FailureDetectorTest, RegularHeartbeats) {
+  PhiAccrualDetector detector(1.0);
+  ASSERT_FALSE(detector.hasHeartbeat());
+  ASSERT_EQ(detector.phi(100), 0);
+
+  // Heartbeats every 0.2 sec with small jitter
+  double time = 0;
+  for (unsigned i = 0; i < 50; ++i) {
+    time += (i % 2 == 0) ? 0.19 : 0.21;
+    detector.heartbeat(time);
+  }
+  ASSERT_TRUE(detector.hasHeartbeat());
+  ASSERT_EQ(detector.numIntervals(), 49u);
+  // Suspicion grows with the time since the last heartbeat
+  ASSERT_LT(detector.phi(time + 0.2), 1);
+  ASSERT_LT(detector.phi(time + 0.2), detector.phi(time + 0.3));
+  ASSERT_LT(detector.phi(time + 0.3), detector.phi(time + 0.5));
+  ASSERT_GT(detector.phi(time + 1.0), 8);
+
+  // Outdated heartbeats are ignored
+  detector.heartbeat(time - 1);
+  ASSERT_EQ(detector.numIntervals(), 49u);
+
+  detector.reset();
+  ASSERT_FALSE(detector.hasHeartbeat());
+}
+
+TEST(FailureDetectorTest, SlowPeer) {
+  // A peer with irregular heartbeats is tolerated longer than a regular one
+  PhiAccrualDetector regular(1.0), irregular(1.0);
+  double time = 0, irregular_time = 0;
+  for (unsigned i = 0; i < 20; ++i) {
+    time += 0.5;
+    regular.heartbeat(time);
+    irregular_time += (i % 2 == 0) ? 0.2 : 0.8;
+    irregular.heartbeat(irregular_time);
+  }
+  ASSERT_EQ(time, irregular_time);
+  ASSERT_GT(regular.phi(time + 1.0), 8);
+  ASSERT_LT(irregular.phi(time + 1.0), 3);
+
+  // The acceptable pause delays suspicion
+  PhiAccrualDetector paused(1.0, 1.0);
+  time = 0;
+  for (unsigned i = 0; i < 20; ++i) {
+    time += 0.5;
+    paused.heartbeat(time);
+  }
+  ASSERT_LT(paused.phi(time + 1.0), 1);
+}
+
+TEST(FailureDetectorTest, WindowSize) {
+  PhiAccrualDetector detector(1.0, 0, 0.05, 10);
+  double time = 0;
+  for (unsigned i = 0; i < 20; ++i) {
+    time += 5.0;
+    detector.heartbeat(time);
+  }
+  // Only the latest intervals determine the distribution
+  for (unsigned i = 0; i < 10; ++i) {
+    time += 0.1;
+    detector.heartbeat(time);
+  }
+  ASSERT_EQ(detector.numIntervals(), 10u);
+  ASSERT_GT(detector.phi(time + 1.0), 8);
+}
@@ -0,0 +1,132 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <dpgo_ros/NeighborCache.h>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+TEST(NeighborCacheTest, Poses) {
+  const unsigned d = 3;
+  NeighborPoseCache cache(d);
+  // Insert out of order
+  for (unsigned frame : {5u, 1u, 3u}) {
+    for (unsigned robot : {2u, 0u}) {
+      Matrix T = Matrix::Constant(d, d + 1, 10 * robot + frame);
+      ASSERT_TRUE(cache.insert(PoseID(robot, frame), T, 0));
+    }
+  }
+  ASSERT_EQ(cache.size(), 6u);
+  ASSERT_EQ(cache.numRobots(), 2u);
+  ASSERT_GT(cache.memoryUsage(), 6 * d * (d + 1) * sizeof(double));
+
+  Matrix T;
+  ASSERT_TRUE(cache.find(PoseID(2, 3), T));
+  ASSERT_EQ(T.rows(), d);
+  ASSERT_EQ(T.cols(), d + 1);
+  ASSERT_EQ(T(0, 0), 23);
+  ASSERT_FALSE(cache.find(PoseID(2, 4), T));
+  ASSERT_FALSE(cache.find(PoseID(1, 3), T));
+  ASSERT_FALSE(cache.insert(PoseID(1, 0), Matrix::Zero(d, d), 0));
+
+  // Overwrite
+  ASSERT_TRUE(cache.insert(PoseID(0, 1), Matrix::Constant(d, d + 1, -1), 0));
+  ASSERT_EQ(cache.size(), 6u);
+  ASSERT_TRUE(cache.find(PoseID(0, 1), T));
+  ASSERT_EQ(T(2, 3), -1);
+
+  // Iteration is ordered by pose ID
+  std::vector<PoseID> ids;
+  cache.forEach([&](const PoseID &id, const Eigen::Map<const Matrix> &pose) {
+    ids.push_back(id);
+    ASSERT_EQ(pose.rows(), d);
+  });
+  ASSERT_EQ(ids.size(), 6u);
+  ASSERT_EQ(ids.front().robot_id, 0u);
+  ASSERT_EQ(ids.front().frame_id, 1u);
+  ASSERT_EQ(ids.back().robot_id, 2u);
+  ASSERT_EQ(ids.back().frame_id, 5u);
+}
+
+TEST(NeighborCacheTest, PoseEviction) {
+  const unsigned d = 2;
+  NeighborPoseCache cache(d, 4);
+  const Matrix T = Matrix::Identity(d, d + 1);
+  ASSERT_TRUE(cache.insert(PoseID(1, 0), T, 0));
+  ASSERT_TRUE(cache.insert(PoseID(1, 1), T, 0));
+  ASSERT_TRUE(cache.insert(PoseID(2, 0), T, 1));
+  ASSERT_TRUE(cache.insert(PoseID(3, 0), T, 2));
+
+  // Robot 1 was seen least recently
+  ASSERT_TRUE(cache.insert(PoseID(3, 1), T, 2));
+  ASSERT_EQ(cache.size(), 3u);
+  Matrix pose;
+  ASSERT_FALSE(cache.find(PoseID(1, 0), pose));
+  ASSERT_TRUE(cache.find(PoseID(2, 0), pose));
+
+  // A single robot cannot exceed the capacity
+  ASSERT_TRUE(cache.insert(PoseID(3, 2), T, 3));
+  ASSERT_TRUE(cache.insert(PoseID(3, 3), T, 3));
+  ASSERT_FALSE(cache.insert(PoseID(3, 4), T, 3));
+  ASSERT_EQ(cache.size(), 4u);
+  ASSERT_EQ(cache.numRobots(), 1u);
+
+  ASSERT_EQ(cache.evictIdleRobots(5, 2), 0u);
+  ASSERT_EQ(cache.evictIdleRobots(6, 2), 1u);
+  ASSERT_EQ(cache.size(), 0u);
+}
+
+TEST(NeighborCacheTest, EdgeWeights) {
+  EdgeWeightCache cache;
+  for (unsigned i = 0; i < 1000; ++i) {
+    const EdgeID edge_id(PoseID(0, i), PoseID(1 + i % 3, 2 * i));
+    ASSERT_TRUE(cache.insert(edge_id, i / 1000.0, 0));
+  }
+  ASSERT_EQ(cache.size(), 1000u);
+  ASSERT_GE(cache.memoryUsage(), 2000u * sizeof(double));
+
+  double weight = 0;
+  ASSERT_TRUE(cache.find(EdgeID(PoseID(0, 10), PoseID(2, 20)), weight));
+  ASSERT_DOUBLE_EQ(weight, 0.01);
+  ASSERT_FALSE(cache.find(EdgeID(PoseID(0, 10), PoseID(2, 21)), weight));
+  ASSERT_FALSE(cache.find(EdgeID(PoseID(2, 20), PoseID(0, 10)), weight));
+
+  // Overwrite
+  ASSERT_TRUE(cache.insert(EdgeID(PoseID(0, 10), PoseID(2, 20)), 1.0, 1));
+  ASSERT_EQ(cache.size(), 1000u);
+  ASSERT_TRUE(cache.find(EdgeID(PoseID(0, 10), PoseID(2, 20)), weight));
+  ASSERT_DOUBLE_EQ(weight, 1.0);
+
+  size_t count = 0;
+  cache.forEach([&](const EdgeID &, double) { count++; });
+  ASSERT_EQ(count, 1000u);
+
+  // Robots 1 and 3 were last seen in round 0
+  ASSERT_EQ(cache.evictIdleRobots(2, 1), 2u);
+  ASSERT_EQ(cache.size(), 333u);
+  ASSERT_TRUE(cache.find(EdgeID(PoseID(0, 10), PoseID(2, 20)), weight));
+  ASSERT_FALSE(cache.find(EdgeID(PoseID(0, 0), PoseID(1, 0)), weight));
+}
+
+TEST(NeighborCacheTest, EdgeWeightCapacity) {
+  EdgeWeightCache cache(10);
+  for (unsigned i = 0; i < 10; ++i) {
+    ASSERT_TRUE(cache.insert(EdgeID(PoseID(0, i), PoseID(1, i)), 1.0, 0));
+  }
+  // Robot 1 is evicted to make room for robot 2
+  ASSERT_TRUE(cache.insert(EdgeID(PoseID(0, 0), PoseID(2, 0)), 1.0, 1));
+  ASSERT_EQ(cache.size(), 1u);
+  double weight;
+  ASSERT_FALSE(cache.find(EdgeID(PoseID(0, 0), PoseID(1, 0)), weight));
+
+  for (unsigned i = 1; i < 10; ++i) {
+    ASSERT_TRUE(cache.insert(EdgeID(PoseID(0, i), PoseID(2, i)), 1.0, 1));
+  }
+  // Edges between the same pair of robots cannot exceed the capacity
+  ASSERT_FALSE(cache.insert(EdgeID(PoseID(0, 10), PoseID(2, 10)), 1.0, 1));
+  ASSERT_EQ(cache.size(), 10u);
+}
@@ -0,0 +1,87 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <dpgo_ros/partition.h>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+namespace {
+
+RelativeSEMeasurement makeMeasurement(size_t p1, size_t p2) {
+  return RelativeSEMeasurement(0, 0, p1, p2, Matrix::Identity(3, 3), Matrix::Zero(3, 1), 1.0, 1.0);
+}
+
+// Trajectory that visits place A, then place B, then revisits A and B,
+// with a loop closure between every pair of revisited poses
+std::vector<RelativeSEMeasurement> makeRevisitDataset(size_t segment_length) {
+  std::vector<RelativeSEMeasurement> measurements;
+  const size_t n = 4 * segment_length;
+  for (size_t i = 0; i + 1 < n; ++i) measurements.push_back(makeMeasurement(i, i + 1));
+  for (size_t i = 0; i < segment_length; ++i) {
+    measurements.push_back(makeMeasurement(i, 2 * segment_length + i));
+    measurements.push_back(makeMeasurement(segment_length + i, 3 * segment_length + i));
+  }
+  return measurements;
+}
+
+}  // namespace
+
+TEST(PartitionTest, Contiguous) {
+  const auto measurements = makeRevisitDataset(25);
+  PosePartition partition = partitionContiguous(100, 2, measurements);
+  ASSERT_EQ(partition.poseIDs[49].robot_id, 0u);
+  ASSERT_EQ(partition.poseIDs[49].frame_id, 49u);
+  ASSERT_EQ(partition.poseIDs[50].robot_id, 1u);
+  ASSERT_EQ(partition.poseIDs[50].frame_id, 0u);
+  // One odometry edge and all loop closures cross the cut
+  ASSERT_EQ(partition.numSharedEdges, 51u);
+  ASSERT_EQ(partition.numSharedPoses, 100u);
+}
+
+TEST(PartitionTest, MinEdgeCut) {
+  // Dense loop closures around the middle of the trajectory
+  const size_t n = 100;
+  std::vector<RelativeSEMeasurement> measurements;
+  for (size_t i = 0; i + 1 < n; ++i) measurements.push_back(makeMeasurement(i, i + 1));
+  for (size_t i = 40; i < 54; ++i) {
+    for (size_t j = i + 2; j <= i + 5; ++j) measurements.push_back(makeMeasurement(i, j));
+  }
+  PartitionParameters params;
+  params.numChunksPerRobot = 50;
+  params.maxImbalance = 0.2;
+  PosePartition partition = partitionMinEdgeCut(n, 2, measurements, params);
+
+  // The cut moves past the loop closures, so only odometry crosses it
+  ASSERT_EQ(partition.numSharedEdges, 1u);
+  ASSERT_EQ(partition.numSharedPoses, 2u);
+  ASSERT_EQ(partitionContiguous(n, 2, measurements).numSharedEdges, 15u);
+}
+
+TEST(PartitionTest, MinEdgeCutContiguous) {
+  const size_t n = 100;
+  const auto measurements = makeRevisitDataset(25);
+  PartitionParameters params;
+  params.numChunksPerRobot = 10;
+  PosePartition partition = partitionMinEdgeCut(n, 2, measurements, params);
+  ASSERT_LT(partition.numSharedEdges, partitionContiguous(n, 2, measurements).numSharedEdges);
+
+  // Each robot receives a range of the trajectory, so consecutive local pose IDs
+  // are exactly the odometry of the dataset
+  std::vector<int> last_frame(2, -1);
+  for (size_t idx = 0; idx < n; ++idx) {
+    const PoseID &id = partition.poseIDs[idx];
+    ASSERT_LT(id.robot_id, 2u);
+    ASSERT_EQ((int) id.frame_id, last_frame[id.robot_id] + 1);
+    last_frame[id.robot_id] = id.frame_id;
+    if (idx > 0 && partition.poseIDs[idx - 1].robot_id == id.robot_id) {
+      ASSERT_EQ(partition.poseIDs[idx - 1].frame_id + 1, id.frame_id);
+    } else if (idx > 0) {
+      ASSERT_EQ(id.frame_id, 0u);
+    }
+  }
+}
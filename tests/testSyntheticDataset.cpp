@@ -0,0 +1,74 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <dpgo_ros/SyntheticDataset.h>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+TEST(SyntheticDatasetTest, NoiseFreeMeasurementsMatchGroundTruth) {
+  for (unsigned d : {2u, 3u}) {
+    SyntheticDatasetParameters params;
+    params.d = d;
+    params.numRobots = 4;
+    params.numPosesPerRobot = 200;
+    params.numCellsPerSide = 5;
+    params.rotationNoiseStd = 0;
+    params.translationNoiseStd = 0;
+    params.storeGroundTruth = true;
+    SyntheticDataset dataset = generateSyntheticDataset(params);
+    ASSERT_EQ(dataset.measurements.size(), 4u);
+    ASSERT_EQ(dataset.groundTruth.size(), 4u);
+    ASSERT_GT(dataset.numIntraLoopClosures, 0u);
+    ASSERT_GT(dataset.numInterLoopClosures, 0u);
+    ASSERT_EQ(dataset.numOutliers, 0u);
+
+    size_t num_odometry = 0;
+    size_t num_shared = 0;
+    for (unsigned robot = 0; robot < params.numRobots; ++robot) {
+      for (const auto &m : dataset.measurements[robot]) {
+        ASSERT_TRUE(m.r1 == robot || m.r2 == robot);
+        ASSERT_LT(m.p1, params.numPosesPerRobot);
+        ASSERT_LT(m.p2, params.numPosesPerRobot);
+        if (m.r1 == m.r2 && m.p1 + 1 == m.p2) num_odometry++;
+        if (m.r1 != m.r2) num_shared++;
+        const Matrix R1 = dataset.groundTruth[m.r1].rotation(m.p1);
+        const Matrix t1 = dataset.groundTruth[m.r1].translation(m.p1);
+        const Matrix R2 = dataset.groundTruth[m.r2].rotation(m.p2);
+        const Matrix t2 = dataset.groundTruth[m.r2].translation(m.p2);
+        ASSERT_LE((m.R - R1.transpose() * R2).norm(), 1e-9);
+        ASSERT_LE((m.t - R1.transpose() * (t2 - t1)).norm(), 1e-9);
+      }
+    }
+    ASSERT_EQ(num_odometry, params.numRobots * (params.numPosesPerRobot - 1));
+    // Shared loop closures are included for both robots
+    ASSERT_EQ(num_shared, 2 * dataset.numInterLoopClosures);
+  }
+}
+
+TEST(SyntheticDatasetTest, OutlierFraction) {
+  SyntheticDatasetParameters params;
+  params.numRobots = 8;
+  params.numPosesPerRobot = 1000;
+  params.numCellsPerSide = 8;
+  params.intraLoopClosureProbability = 0.5;
+  params.interLoopClosureProbability = 0.5;
+  params.outlierFraction = 0.5;
+  params.seed = 7;
+  SyntheticDataset dataset = generateSyntheticDataset(params);
+  const size_t num_loop_closures = dataset.numIntraLoopClosures + dataset.numInterLoopClosures;
+  ASSERT_GT(num_loop_closures, 1000u);
+  const double fraction = (double) dataset.numOutliers / num_loop_closures;
+  ASSERT_NEAR(fraction, 0.5, 0.05);
+
+  // Same seed gives the same dataset
+  SyntheticDataset dataset_repeat = generateSyntheticDataset(params);
+  ASSERT_EQ(dataset_repeat.numOutliers, dataset.numOutliers);
+  for (unsigned robot = 0; robot < params.numRobots; ++robot) {
+    ASSERT_EQ(dataset_repeat.measurements[robot].size(), dataset.measurements[robot].size());
+  }
+}
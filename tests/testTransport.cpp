@@ -0,0 +1,106 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+#include <dpgo_ros/InMemoryTransport.h>
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace dpgo_ros;
+
+TEST(TransportTest, InMemoryDelivery) {
+  InMemoryBus bus;
+  InMemoryTransport transport0(bus, 0);
+  InMemoryTransport transport1(bus, 1);
+
+  // Robot 1 listens to commands and public poses of robot 0
+  std::vector<CommandConstPtr> commands;
+  std::vector<PublicPosesConstPtr> poses;
+  PGOAgentMessageHandlers handlers;
+  handlers.command = [&commands](const CommandConstPtr &msg) { commands.push_back(msg); };
+  handlers.public_poses = [&poses](const PublicPosesConstPtr &msg) { poses.push_back(msg); };
+  transport1.subscribe(0, handlers);
+
+  CommandPtr cmd1 = boost::make_shared<Command>();
+  cmd1->command = Command::INITIALIZE;
+  CommandPtr cmd2 = boost::make_shared<Command>();
+  cmd2->command = Command::UPDATE;
+  PublicPosesPtr pose_msg = boost::make_shared<PublicPoses>();
+  transport0.publishCommand(cmd1);
+  transport0.publishPublicPoses(pose_msg);
+  transport0.publishCommand(cmd2);
+  // Nobody subscribed to status or to messages of robot 1
+  transport0.publishStatus(boost::make_shared<Status>());
+  transport1.publishCommand(boost::make_shared<Command>());
+
+  // Nothing is delivered before spinning
+  ASSERT_TRUE(commands.empty());
+  ASSERT_EQ(bus.numQueuedMessages(), 3u);
+  bus.spinOnce();
+  ASSERT_EQ(bus.numQueuedMessages(), 0u);
+
+  // Messages are delivered in order and without copies
+  ASSERT_EQ(commands.size(), 2u);
+  ASSERT_EQ(commands[0].get(), cmd1.get());
+  ASSERT_EQ(commands[1].get(), cmd2.get());
+  ASSERT_EQ(poses.size(), 1u);
+  ASSERT_EQ(poses[0].get(), pose_msg.get());
+}
+
+TEST(TransportTest, InMemoryPublishDuringSpin) {
+  InMemoryBus bus;
+  InMemoryTransport transport0(bus, 0);
+  InMemoryTransport transport1(bus, 1);
+
+  // Robot 1 replies to every command of robot 0, and robot 0 counts the replies
+  int num_replies = 0;
+  PGOAgentMessageHandlers handlers1;
+  handlers1.command = [&transport1](const CommandConstPtr &msg) {
+    transport1.publishStatus(boost::make_shared<Status>());
+  };
+  transport1.subscribe(0, handlers1);
+  PGOAgentMessageHandlers handlers0;
+  handlers0.status = [&num_replies](const StatusConstPtr &msg) { num_replies++; };
+  transport0.subscribe(1, handlers0);
+
+  transport0.publishCommand(boost::make_shared<Command>());
+  ASSERT_EQ(bus.spinOnce(), 1u);
+  ASSERT_EQ(num_replies, 0);
+  // Reply is delivered at the next spin
+  ASSERT_EQ(bus.spinOnce(), 1u);
+  ASSERT_EQ(num_replies, 1);
+  ASSERT_EQ(bus.spinOnce(), 0u);
+}
+
+TEST(TransportTest, InMemoryArrival) {
+  ros::Time::init();
+  InMemoryBus bus;
+  InMemoryTransport transport0(bus, 0);
+  InMemoryTransport transport1(bus, 1);
+
+  // Arrivals of commands and status messages are reported before their callbacks
+  std::vector<std::string> events;
+  PGOAgentMessageHandlers handlers;
+  handlers.command = [&events](const CommandConstPtr &msg) { events.push_back("command"); };
+  handlers.status = [&events](const StatusConstPtr &msg) { events.push_back("status"); };
+  handlers.public_poses = [&events](const PublicPosesConstPtr &msg) { events.push_back("public_poses"); };
+  handlers.arrival = [&events](const ros::Time &time) { events.push_back("arrival"); };
+  transport1.subscribe(0, handlers);
+
+  transport0.publishCommand(boost::make_shared<Command>());
+  transport0.publishPublicPoses(boost::make_shared<PublicPoses>());
+  transport0.publishStatus(boost::make_shared<Status>());
+  ASSERT_EQ(bus.spinOnce(), 3u);
+  const std::vector<std::string> expected{"arrival", "command", "public_poses", "arrival", "status"};
+  ASSERT_EQ(events, expected);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
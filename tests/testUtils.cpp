@@ -25,6 +25,21 @@ TEST(UtilsTest, MatrixMsg) {
   ASSERT_LE((MatOut - Mat).norm(), 1e-6);
 }
 
+TEST(UtilsTest, MatrixMsgInPlace) {
+  DPGO::Matrix Mat(2, 3);
+  Mat << 1.0, 2.0, 3.0, 4.0, 5.0, 6.0;
+
+  // Reuse a message that previously stored a matrix of different size
+  MatrixMsg msg = MatrixToMsg(DPGO::Matrix::Identity(3, 3));
+  MatrixToMsg(Mat, msg);
+  ASSERT_EQ(msg.rows, 2);
+  ASSERT_EQ(msg.cols, 3);
+  ASSERT_EQ(msg.values.size(), 6);
+
+  DPGO::Matrix MatOut = MatrixFromMsg(msg);
+  ASSERT_LE((MatOut - Mat).norm(), 1e-6);
+}
+
 TEST(UtilsTest, PoseGraphEdge) {
   size_t r1 = 0;
   size_t r2 = 1;
@@ -52,6 +67,62 @@ TEST(UtilsTest, PoseGraphEdge) {
   ASSERT_LE((t-mOut.t).norm(), 1e-6);
 }
 
+TEST(UtilsTest, FixedSizeConversions) {
+  Eigen::Matrix3d R;
+  R << -0.2727695, -0.4248134,  0.8632094,
+       -0.5148591,  0.8223981,  0.2420361,
+       -0.8127219, -0.3784111, -0.4430441;
+  const Eigen::Vector3d t(-1.5, 2.1, 3.9);
+  geometry_msgs::Pose pose;
+  pose.orientation = RotationToQuaternionMsg3d(R);
+  pose.position = TranslationToPointMsg3d(t);
+  ASSERT_LE((RotationFromPoseMsg3d(pose) - R).norm(), 1e-6);
+  ASSERT_LE((TranslationFromPoseMsg3d(pose) - t).norm(), 1e-12);
+  // Dynamic versions are wrappers of the fixed-size versions
+  ASSERT_LE((RotationFromPoseMsg(pose) - R).norm(), 1e-6);
+  ASSERT_LE((TranslationFromPoseMsg(pose) - t).norm(), 1e-12);
+
+  // Batch conversion of a trajectory
+  const unsigned n = 5;
+  DPGO::Matrix T(3, 4 * n);
+  for (unsigned i = 0; i < n; ++i) {
+    T.block(0, 4 * i, 3, 3) = Eigen::AngleAxisd(0.3 * i, Eigen::Vector3d(1, 2, 3).normalized()).toRotationMatrix();
+    T.block(0, 4 * i + 3, 3, 1) = Eigen::Vector3d(i, -2.0 * i, 0.5);
+  }
+  const auto poses = TrajectoryToPoseMsgs(n, T);
+  ASSERT_EQ(poses.size(), n);
+  pose_graph_tools::PoseGraph pose_graph = TrajectoryToPoseGraphMsg(7, 3, n, T);
+  ASSERT_EQ(pose_graph.nodes.size(), n);
+  for (unsigned i = 0; i < n; ++i) {
+    ASSERT_LE((RotationFromPoseMsg3d(poses[i]) - T.block(0, 4 * i, 3, 3)).norm(), 1e-9);
+    ASSERT_LE((TranslationFromPoseMsg3d(poses[i]) - T.block(0, 4 * i + 3, 3, 1)).norm(), 1e-12);
+    ASSERT_EQ(pose_graph.nodes[i].robot_id, 7);
+    ASSERT_EQ(pose_graph.nodes[i].key, i);
+  }
+}
+
+TEST(UtilsTest, PoseGraphEdges) {
+  std::vector<DPGO::RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i < 4; ++i) {
+    DPGO::Matrix R = Eigen::AngleAxisd(0.2 * i, Eigen::Vector3d::UnitY()).toRotationMatrix();
+    DPGO::Matrix t = Eigen::Vector3d(i, 1, 2);
+    measurements.emplace_back(0, i % 2, i, i + 1, R, t, 1.0, 1.0);
+  }
+  std::vector<pose_graph_tools::PoseGraphEdge> edges;
+  RelativeMeasurementsToMsg(measurements, edges);
+  ASSERT_EQ(edges.size(), measurements.size());
+  const auto measurements_out = RelativeMeasurementsFromMsg(edges);
+  ASSERT_EQ(measurements_out.size(), measurements.size());
+  for (size_t k = 0; k < measurements.size(); ++k) {
+    ASSERT_EQ(measurements_out[k].r2, measurements[k].r2);
+    ASSERT_EQ(measurements_out[k].p1, measurements[k].p1);
+    ASSERT_LE((measurements_out[k].R - measurements[k].R).norm(), 1e-9);
+    ASSERT_LE((measurements_out[k].t - measurements[k].t).norm(), 1e-12);
+    // Odometry is an inlier by default
+    ASSERT_EQ(measurements_out[k].fixedWeight, measurements[k].r2 == 0);
+  }
+}
+
 TEST(UtilsTest, StatusMsg) {
   DPGO::PGOAgentStatus status(0, PGOAgentState::WAIT_FOR_DATA, 1, 1, true, 0.5);
   Status msg = statusToMsg(status);
@@ -69,6 +140,165 @@ TEST(UtilsTest, StatusMsg) {
   ASSERT_EQ(PGOAgentState::INITIALIZED, Status::INITIALIZED);
 }
 
+TEST(UtilsTest, ExtendTrajectoryByOdometry) {
+  const unsigned r = 5, d = 3;
+  DPGO::LiftedPoseArray X(r, d, 2);
+  X.setData(DPGO::Matrix::Random(r, (d + 1) * 2));
+
+  std::vector<RelativeSEMeasurement> odometry;
+  DPGO::Matrix R = Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+  DPGO::Matrix t(3, 1);
+  t << 1.0, 0.5, 0.0;
+  odometry.emplace_back(0, 0, 0, 1, R, t, 1.0, 1.0);
+  odometry.emplace_back(0, 0, 1, 2, R, t, 1.0, 1.0);
+
+  const DPGO::Matrix XData = X.getData();
+  extendTrajectoryByOdometry(X, 4, odometry);
+  ASSERT_EQ(X.n(), 4);
+  ASSERT_LE((X.getData().leftCols(8) - XData).norm(), 1e-9);
+  ASSERT_LE((X.rotation(2) - X.rotation(1) * R).norm(), 1e-9);
+  ASSERT_LE((X.translation(2) - X.translation(1) - X.rotation(1) * t).norm(), 1e-9);
+  // Pose 3 has no odometry and copies pose 2
+  ASSERT_LE((X.pose(3) - X.pose(2)).norm(), 1e-9);
+}
+
+TEST(UtilsTest, SummarizePoseGraph) {
+  pose_graph_tools::PoseGraph pose_graph;
+  auto addEdge = [&](unsigned robot_from, unsigned key_from, unsigned robot_to, unsigned key_to) {
+    pose_graph_tools::PoseGraphEdge edge;
+    edge.robot_from = robot_from;
+    edge.key_from = key_from;
+    edge.robot_to = robot_to;
+    edge.key_to = key_to;
+    pose_graph.edges.push_back(edge);
+  };
+  addEdge(1, 0, 1, 1);
+  addEdge(1, 1, 1, 2);
+  addEdge(1, 0, 1, 2);  // private loop closure
+  addEdge(0, 5, 1, 1);  // shared loop closure owned by robot 0
+  addEdge(1, 2, 2, 7);  // shared loop closure owned by robot 1
+  PoseGraphSummary summary = summarizePoseGraph(pose_graph, 1);
+  ASSERT_EQ(summary.numEdges, 5u);
+  ASSERT_EQ(summary.numLoopClosures, 2u);
+}
+
+TEST(UtilsTest, LiftedRankRatio) {
+  const unsigned d = 3;
+  const unsigned r = 5;
+  const unsigned n = 10;
+  // Rotations lifted by the same matrix span a d-dimensional subspace
+  Matrix YLift = Matrix::Zero(r, d);
+  YLift.topRows(d) = Matrix::Identity(d, d);
+  LiftedPoseArray X(r, d, n);
+  for (unsigned i = 0; i < n; ++i) {
+    const Matrix R = Eigen::AngleAxisd(0.3 * i, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+    X.rotation(i) = YLift * R;
+    X.translation(i) = Vector::Zero(r);
+  }
+  Matrix gram = liftedRotationGram(X);
+  ASSERT_EQ(gram.rows(), r);
+  ASSERT_NEAR(gram.trace(), n * d, 1e-9);
+  ASSERT_LT(liftedRankRatio(gram, d), 1e-12);
+
+  // Rotate one pose out of the subspace
+  Matrix Q = Matrix::Identity(r, r);
+  Q.block(2, 2, 2, 2) << 0, -1, 1, 0;
+  X.rotation(0) = Q * X.rotation(0);
+  gram = liftedRotationGram(X);
+  ASSERT_GT(liftedRankRatio(gram, d), 0.01);
+}
+
+TEST(UtilsTest, LoadBalancedUpdateWeights) {
+  std::vector<RobotUpdateStatistics> stats(4);
+  // Fast robot and slow robot with the same cost decrease
+  stats[0].valid = true;
+  stats[0].costDecrease = 1.0;
+  stats[0].elapsedMs = 10;
+  stats[0].staleness = 4;
+  stats[1].valid = true;
+  stats[1].costDecrease = 1.0;
+  stats[1].elapsedMs = 100;
+  stats[1].staleness = 4;
+  // Robot that just updated
+  stats[2].valid = true;
+  stats[2].costDecrease = 1.0;
+  stats[2].elapsedMs = 10;
+  stats[2].staleness = 1;
+  // Robot 3 has not reported
+  const auto weights = loadBalancedUpdateWeights(stats, 0.05);
+  ASSERT_EQ(weights.size(), 4u);
+  ASSERT_NEAR(weights[0], 0.1, 1e-12);
+  ASSERT_NEAR(weights[1], 0.01, 1e-12);
+  ASSERT_NEAR(weights[2], 0.025, 1e-12);
+  ASSERT_NEAR(weights[3], 0.1, 1e-12);
+
+  // Minimum weight
+  stats[1].costDecrease = 0;
+  ASSERT_NEAR(loadBalancedUpdateWeights(stats, 0.05)[1], 0.005, 1e-12);
+
+  // Uniform weights without any decrease
+  for (auto &stat : stats) stat.valid = false;
+  for (double weight : loadBalancedUpdateWeights(stats, 0.05)) ASSERT_EQ(weight, 1.0);
+}
+
+TEST(UtilsTest, CompareMeasurements) {
+  const Matrix R = Matrix::Identity(3, 3);
+  const Matrix t = Matrix::Zero(3, 1);
+  std::vector<RelativeSEMeasurement> previous;
+  for (unsigned i = 0; i < 5; ++i) {
+    previous.emplace_back(0, 0, i, i + 1, R, t, 1.0, 1.0);
+  }
+  previous.emplace_back(0, 1, 2, 7, R, t, 1.0, 1.0);
+  ASSERT_TRUE(compareMeasurements(previous, previous).empty());
+
+  std::vector<RelativeSEMeasurement> current(previous.begin() + 1, previous.end());
+  current.back().weight = 0;
+  current.emplace_back(0, 0, 5, 6, R, t, 1.0, 1.0);
+  current.emplace_back(0, 2, 6, 1, R, t, 1.0, 1.0);
+  const auto changes = compareMeasurements(previous, current);
+  ASSERT_FALSE(changes.empty());
+  ASSERT_EQ(changes.numAdded, 2u);
+  ASSERT_EQ(changes.numRemoved, 1u);
+  ASSERT_EQ(changes.numModified, 1u);
+}
+
+TEST(UtilsTest, LeaderFailover) {
+  // Robot 0 leads robots 1, 2 and 3, and robot 2 is inactive
+  const std::vector<bool> team_active{true, true, false, true};
+  ASSERT_EQ(leaderSuccessor(0, team_active), 1u);
+  ASSERT_EQ(leaderSuccessor(1, team_active), 0u);
+  ASSERT_EQ(leaderSuccessor(0, std::vector<bool>{true, false}), 2u);
+
+  // The successor takes over, and deactivates the failed leader
+  unsigned successor_leader = 0;
+  std::vector<bool> successor_active = team_active;
+  const unsigned successor = leaderSuccessor(successor_leader, successor_active);
+  ASSERT_TRUE(followLeaderTakeover(successor, successor, successor_leader, successor_active));
+  ASSERT_EQ(successor_leader, 1u);
+  ASSERT_FALSE(successor_active[0]);
+
+  // Followers only accept the designated successor, with its own cluster ID
+  unsigned follower_leader = 0;
+  std::vector<bool> follower_active = team_active;
+  ASSERT_FALSE(followLeaderTakeover(3, 3, follower_leader, follower_active));
+  ASSERT_FALSE(followLeaderTakeover(2, 2, follower_leader, follower_active));
+  ASSERT_FALSE(followLeaderTakeover(1, 0, follower_leader, follower_active));
+  ASSERT_EQ(follower_leader, 0u);
+  ASSERT_EQ(follower_active, team_active);
+  ASSERT_TRUE(followLeaderTakeover(1, 1, follower_leader, follower_active));
+  ASSERT_EQ(follower_leader, 1u);
+  ASSERT_EQ(follower_active, successor_active);
+  // A second takeover needs the successor of the new leader
+  ASSERT_FALSE(followLeaderTakeover(1, 1, follower_leader, follower_active));
+
+  // The old leader was only suspected to fail, and deactivates itself once it receives TAKEOVER
+  unsigned old_leader_leader = 0;
+  std::vector<bool> old_leader_active = team_active;
+  ASSERT_TRUE(followLeaderTakeover(1, 1, old_leader_leader, old_leader_active));
+  ASSERT_EQ(old_leader_leader, 1u);
+  ASSERT_FALSE(old_leader_active[0]);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   ros::init(argc, argv, "dpgo_ros_test_utils");